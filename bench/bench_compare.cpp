@@ -0,0 +1,300 @@
+// compares VastJSON modes with full parsers (plain nlohmann::json, simdjson on-demand and RapidJSON SAX)
+// over the same workloads: load whole file, fetch k random keys, and iterate all keys.
+// simdjson and RapidJSON are optional: they are compiled in when vendored on 'libs/' (see bench/makefile).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <vastjson/VastJSON.hpp> // 'src' included
+
+#if __has_include(<simdjson.h>)
+#include <simdjson.h>
+#define VASTJSON_BENCH_SIMDJSON
+#endif
+
+#if __has_include(<rapidjson/reader.h>)
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/reader.h>
+#define VASTJSON_BENCH_RAPIDJSON
+#endif
+
+#include "bench_data.hpp"
+
+using namespace vastjson;
+using namespace vastjson_bench;
+
+// run of one workload, returning number of entries seen (must agree between libraries)
+using Run = std::function<std::size_t()>;
+
+// sizes of touched values (keeps work observable)
+static volatile std::size_t sink = 0;
+
+static std::size_t envNumber(const char* name, std::size_t def)
+{
+   const char* env = std::getenv(name);
+   std::size_t n = env ? std::strtoull(env, nullptr, 10) : 0;
+   return n ? n : def;
+}
+
+// best time (of 'reps' runs) and peak memory over resident memory before run
+static void measure(const std::string& dataset, const std::string& workload, const std::string& library, std::size_t bytes, const Run& run)
+{
+   std::size_t reps = envNumber("VASTJSON_BENCH_REPS", 1);
+   double best = 0;
+   std::size_t peak = 0;
+   std::size_t check = 0;
+   for (std::size_t r = 0; r < reps; r++) {
+#ifdef __GLIBC__
+      malloc_trim(0); // memory freed by previous runs is not resident anymore
+#endif
+      resetPeakRss();
+      std::size_t base = currentRssBytes();
+      auto t0 = std::chrono::steady_clock::now();
+      check = run();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+      std::size_t hwm = peakRssBytes();
+      peak = std::max(peak, (hwm > base) ? hwm - base : 0);
+      best = (r == 0) ? ms : std::min(best, ms);
+   }
+   std::cout << "| " << dataset << " | " << workload << " | " << library << " | " << std::fixed << std::setprecision(1)
+             << best << " | " << (bytes / (1024.0 * 1024.0)) / (best / 1000.0) << " | " << peak / (1024.0 * 1024.0)
+             << " | " << check << " |" << std::endl;
+}
+
+// VastJSON over file, with mode and cache mode (or memory mapped)
+static VastJSON openVast(const std::string& path, ModeVastJSON mode, CacheVastJSON cacheMode, bool mmap)
+{
+   if (mmap)
+      return VastJSON{ MappedFile(path), mode };
+   return VastJSON{ new std::ifstream(path), mode, cacheMode };
+}
+
+static void compareVast(const std::string& dataset, const std::string& path, std::size_t bytes, const std::vector<std::string>& sample)
+{
+   struct Variant
+   {
+      std::string name;
+      ModeVastJSON mode;
+      CacheVastJSON cacheMode;
+      bool mmap;
+   };
+   const Variant variants[] = { { "VastJSON GENERIC", BIG_ROOT_DICT_GENERIC, CACHE_STRING, false },
+                                { "VastJSON NO_ROOT_LIST", BIG_ROOT_DICT_NO_ROOT_LIST, CACHE_STRING, false },
+                                { "VastJSON GENERIC/CACHE_OFFSET", BIG_ROOT_DICT_GENERIC, CACHE_OFFSET, false },
+                                { "VastJSON GENERIC/mmap", BIG_ROOT_DICT_GENERIC, CACHE_OFFSET, true } };
+   for (const Variant& v : variants) {
+      measure(dataset, "load", v.name, bytes, [&]() {
+         VastJSON bigj = openVast(path, v.mode, v.cacheMode, v.mmap);
+         return bigj.size();
+      });
+      measure(dataset, "random keys", v.name, bytes, [&]() {
+         VastJSON bigj = openVast(path, v.mode, v.cacheMode, v.mmap);
+         std::size_t n = 0;
+         for (auto& key : sample) {
+            sink = sink + bigj[key].size();
+            n++;
+         }
+         return n;
+      });
+      measure(dataset, "iterate all", v.name, bytes, [&]() {
+         VastJSON bigj = openVast(path, v.mode, v.cacheMode, v.mmap);
+         bigj.size();
+         std::vector<std::string> keys;
+         for (auto it = bigj.beginCache(); it != bigj.endCache(); it++)
+            keys.push_back(it->first);
+         for (auto& key : keys) {
+            sink = sink + bigj[key].size();
+            bigj.unload(key); // streaming use: one parsed entry at a time
+         }
+         return keys.size();
+      });
+   }
+   // BIG_STRICT parses everything up front (in parallel)
+   measure(dataset, "load", "VastJSON BIG_STRICT", bytes, [&]() {
+      VastJSON bigj{ new std::ifstream(path), BIG_STRICT };
+      return bigj.size();
+   });
+}
+
+static void compareNlohmann(const std::string& dataset, const std::string& path, std::size_t bytes, const std::vector<std::string>& sample)
+{
+   auto parse = [&path]() {
+      std::ifstream ifs(path);
+      return nlohmann::json::parse(ifs);
+   };
+   measure(dataset, "load", "nlohmann::json", bytes, [&]() { return parse().size(); });
+   measure(dataset, "random keys", "nlohmann::json", bytes, [&]() {
+      nlohmann::json j = parse();
+      std::size_t n = 0;
+      for (auto& key : sample) {
+         auto it = j.find(key);
+         if (it != j.end()) {
+            sink = sink + it->size();
+            n++;
+         }
+      }
+      return n;
+   });
+   measure(dataset, "iterate all", "nlohmann::json", bytes, [&]() {
+      nlohmann::json j = parse();
+      for (auto& kv : j.items())
+         sink = sink + kv.value().size();
+      return j.size();
+   });
+}
+
+#ifdef VASTJSON_BENCH_SIMDJSON
+static void compareSimdjson(const std::string& dataset, const std::string& path, std::size_t bytes, const std::vector<std::string>& sample)
+{
+   using namespace simdjson;
+   measure(dataset, "load", "simdjson on-demand", bytes, [&]() {
+      padded_string json = padded_string::load(path);
+      ondemand::parser parser;
+      ondemand::document doc = parser.iterate(json);
+      std::size_t n = 0;
+      for (auto field : doc.get_object()) {
+         sink = sink + std::string_view(field.unescaped_key()).size(); // value is skipped
+         n++;
+      }
+      return n;
+   });
+   measure(dataset, "random keys", "simdjson on-demand", bytes, [&]() {
+      padded_string json = padded_string::load(path);
+      ondemand::parser parser;
+      ondemand::document doc = parser.iterate(json);
+      ondemand::object obj = doc.get_object();
+      std::size_t n = 0;
+      for (auto& key : sample) {
+         auto value = obj.find_field_unordered(key);
+         if (!value.error()) {
+            sink = sink + std::string_view(value.raw_json()).size();
+            n++;
+         }
+      }
+      return n;
+   });
+   measure(dataset, "iterate all", "simdjson on-demand", bytes, [&]() {
+      padded_string json = padded_string::load(path);
+      ondemand::parser parser;
+      ondemand::document doc = parser.iterate(json);
+      std::size_t n = 0;
+      for (auto field : doc.get_object()) {
+         sink = sink + std::string_view(field.value().raw_json()).size();
+         n++;
+      }
+      return n;
+   });
+}
+#endif
+
+#ifdef VASTJSON_BENCH_RAPIDJSON
+// counts top-level entries (or only those in 'wanted', if given)
+struct TopLevelHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, TopLevelHandler>
+{
+   const std::set<std::string, std::less<>>* wanted{ nullptr };
+   int depth{ 0 };
+   bool counting{ false };
+   std::size_t n{ 0 };
+
+   bool Default()
+   {
+      if (depth == 1)
+         n += counting;
+      return true;
+   }
+   bool Key(const char* str, rapidjson::SizeType len, bool)
+   {
+      if (depth == 1)
+         counting = !wanted || wanted->count(std::string_view(str, len));
+      return true;
+   }
+   bool StartObject()
+   {
+      depth++;
+      return true;
+   }
+   bool EndObject(rapidjson::SizeType)
+   {
+      depth--;
+      return Default();
+   }
+   bool StartArray()
+   {
+      depth++;
+      return true;
+   }
+   bool EndArray(rapidjson::SizeType)
+   {
+      depth--;
+      return Default();
+   }
+};
+
+static void compareRapidjson(const std::string& dataset, const std::string& path, std::size_t bytes, const std::vector<std::string>& sample)
+{
+   auto sax = [&path](const std::set<std::string, std::less<>>* wanted) {
+      std::FILE* f = std::fopen(path.c_str(), "rb");
+      std::vector<char> buf(1 << 16);
+      rapidjson::FileReadStream is(f, buf.data(), buf.size());
+      TopLevelHandler handler;
+      handler.wanted = wanted;
+      rapidjson::Reader reader;
+      reader.Parse(is, handler);
+      std::fclose(f);
+      return handler.n;
+   };
+   measure(dataset, "load", "RapidJSON SAX", bytes, [&]() { return sax(nullptr); });
+   std::set<std::string, std::less<>> wanted(sample.begin(), sample.end());
+   measure(dataset, "random keys", "RapidJSON SAX", bytes, [&]() { return sax(&wanted); });
+   measure(dataset, "iterate all", "RapidJSON SAX", bytes, [&]() { return sax(nullptr); });
+}
+#endif
+
+// usage: app_compare [file.json ...] (root dicts). with no files, synthetic shapes of VASTJSON_BENCH_MB are generated.
+// random keys are VASTJSON_BENCH_KEYS (default 100) distinct keys, and best time of VASTJSON_BENCH_REPS runs is reported.
+int main(int argc, char** argv)
+{
+   std::vector<std::pair<std::string, std::string>> datasets;
+   for (int i = 1; i < argc; i++)
+      datasets.emplace_back(argv[i], argv[i]);
+   if (datasets.empty()) {
+      const Shape shapes[] = { Shape::RootDict, Shape::DeepNesting, Shape::StringHeavy, Shape::NumberHeavy };
+      for (Shape shape : shapes)
+         datasets.emplace_back(shapeName(shape), dataFile(shape, benchMegabytes()));
+   }
+   std::cout << "| dataset | workload | library | time (ms) | MB/s | peak memory (MB) | entries |" << std::endl;
+   std::cout << "|---|---|---|---|---|---|---|" << std::endl;
+   for (auto& ds : datasets) {
+      const std::string& path = ds.second;
+      std::size_t bytes = fileBytes(path);
+      // random sample of keys (indexed once, outside of measures)
+      std::vector<std::string> sample;
+      {
+         VastJSON bigj{ new std::ifstream(path), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET };
+         bigj.size();
+         for (auto it = bigj.beginCache(); it != bigj.endCache(); it++)
+            sample.push_back(it->first);
+      }
+      std::shuffle(sample.begin(), sample.end(), std::mt19937_64(1));
+      sample.resize(std::min(sample.size(), envNumber("VASTJSON_BENCH_KEYS", 100)));
+
+      compareVast(ds.first, path, bytes, sample);
+      compareNlohmann(ds.first, path, bytes, sample);
+#ifdef VASTJSON_BENCH_SIMDJSON
+      compareSimdjson(ds.first, path, bytes, sample);
+#endif
+#ifdef VASTJSON_BENCH_RAPIDJSON
+      compareRapidjson(ds.first, path, bytes, sample);
+#endif
+   }
+   return 0;
+}
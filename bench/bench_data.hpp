@@ -0,0 +1,164 @@
+#pragma once
+
+// synthetic json files and process memory probes (shared by benchmarks)
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+
+namespace vastjson_bench {
+
+// shapes of generated files (all of them are root dicts keyed "k0", "k1", ..., except RootList)
+enum class Shape
+{
+   // small mixed objects
+   RootDict,
+   // same objects, on a root list
+   RootList,
+   // objects and lists nested 64 levels deep
+   DeepNesting,
+   // long strings with escapes and unicode
+   StringHeavy,
+   // lists of integers and doubles
+   NumberHeavy
+};
+
+inline const char* shapeName(Shape shape)
+{
+   switch (shape) {
+   case Shape::RootDict:
+      return "root_dict";
+   case Shape::RootList:
+      return "root_list";
+   case Shape::DeepNesting:
+      return "deep_nesting";
+   case Shape::StringHeavy:
+      return "string_heavy";
+   default:
+      return "number_heavy";
+   }
+}
+
+// size of generated files in MB (env VASTJSON_BENCH_MB, default 100)
+inline std::size_t benchMegabytes()
+{
+   const char* env = std::getenv("VASTJSON_BENCH_MB");
+   std::size_t mb = env ? std::strtoull(env, nullptr, 10) : 0;
+   return mb ? mb : 100;
+}
+
+// appends entry 'i' of shape (one top-level value)
+inline void writeValue(std::string& out, Shape shape, std::size_t i, std::mt19937_64& rng)
+{
+   std::string n = std::to_string(i);
+   switch (shape) {
+   case Shape::RootDict:
+   case Shape::RootList:
+      out += "{\"id\":" + n + ",\"name\":\"item " + n + "\",\"active\":" + ((i % 2) ? "true" : "false");
+      out += ",\"tags\":[\"red\",\"green\",\"blue\"],\"parent\":null,\"score\":" + std::to_string(double(rng() % 100000) / 100.0);
+      out += ",\"pos\":{\"x\":" + std::to_string(rng() % 1000) + ",\"y\":" + std::to_string(rng() % 1000) + "}}";
+      break;
+   case Shape::DeepNesting:
+      for (int d = 0; d < 64; d++)
+         out += (d % 2) ? "[" : "{\"d\":";
+      out += n;
+      for (int d = 63; d >= 0; d--)
+         out += (d % 2) ? "]" : "}";
+      break;
+   case Shape::StringHeavy: {
+      out += "{\"title\":\"entry " + n + " \\\"quoted\\\" caf\\u00e9\",\"body\":\"";
+      for (int c = 0; c < 1024; c++) {
+         char ch = char('a' + (rng() % 26));
+         if (c % 97 == 0)
+            out += "\\n";
+         else
+            out += ch;
+      }
+      out += "\"}";
+      break;
+   }
+   default:
+      out += "{\"ints\":[";
+      for (int c = 0; c < 64; c++)
+         out += (c ? "," : "") + std::to_string(std::int64_t(rng() % 2000000) - 1000000);
+      out += "],\"doubles\":[";
+      for (int c = 0; c < 64; c++)
+         out += (c ? "," : "") + std::to_string(double(rng() % 10000000) / 1000.0 - 5000.0);
+      out += "]}";
+      break;
+   }
+}
+
+// path of generated file with shape and size (generated once, on 'build/data', then reused)
+inline std::string dataFile(Shape shape, std::size_t mb)
+{
+   std::string path = std::string("build/data/") + shapeName(shape) + "_" + std::to_string(mb) + "MB.json";
+   struct stat st;
+   if (::stat(path.c_str(), &st) == 0)
+      return path;
+   std::filesystem::create_directories("build/data");
+   std::ofstream ofs(path + ".tmp", std::ios::binary);
+   std::mt19937_64 rng(42);
+   const std::size_t total = mb << 20;
+   const bool list = (shape == Shape::RootList);
+   std::string chunk = list ? "[" : "{";
+   std::size_t written = 0;
+   for (std::size_t i = 0; written + chunk.length() < total; i++) {
+      if (i)
+         chunk += ",";
+      if (!list)
+         chunk += "\"k" + std::to_string(i) + "\":";
+      writeValue(chunk, shape, i, rng);
+      if (chunk.length() > (1 << 20)) {
+         ofs << chunk;
+         written += chunk.length();
+         chunk.clear();
+      }
+   }
+   chunk += list ? "]" : "}";
+   ofs << chunk;
+   ofs.close();
+   std::rename((path + ".tmp").c_str(), path.c_str());
+   return path;
+}
+
+inline std::size_t fileBytes(const std::string& path)
+{
+   struct stat st;
+   return (::stat(path.c_str(), &st) == 0) ? std::size_t(st.st_size) : 0;
+}
+
+// reads field of /proc/self/status (in bytes), such as "VmHWM" or "VmRSS"
+inline std::size_t procStatusBytes(const std::string& field)
+{
+   std::ifstream ifs("/proc/self/status");
+   std::string line;
+   while (std::getline(ifs, line))
+      if (line.compare(0, field.length() + 1, field + ":") == 0)
+         return std::strtoull(line.c_str() + field.length() + 1, nullptr, 10) * 1024;
+   return 0;
+}
+
+// resets peak resident set size of process (linux only)
+inline void resetPeakRss()
+{
+   std::ofstream ofs("/proc/self/clear_refs");
+   ofs << "5";
+}
+
+inline std::size_t peakRssBytes()
+{
+   return procStatusBytes("VmHWM");
+}
+
+inline std::size_t currentRssBytes()
+{
+   return procStatusBytes("VmRSS");
+}
+
+} // namespace vastjson_bench
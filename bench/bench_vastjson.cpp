@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include <vastjson/VastJSON.hpp> // 'src' included
+
+#include "bench_data.hpp"
+
+using namespace vastjson;
+using namespace vastjson_bench;
+
+// allocations on whole process (counted by all replaceable forms of global operator new; nothrow
+// forms call these by default). each form is paired with its operator delete, over malloc/free.
+static std::atomic<std::size_t> alloc_count{ 0 };
+static std::atomic<std::size_t> alloc_bytes{ 0 };
+
+static void* countedAlloc(std::size_t sz, std::size_t align = 0)
+{
+   alloc_count.fetch_add(1, std::memory_order_relaxed);
+   alloc_bytes.fetch_add(sz, std::memory_order_relaxed);
+   // aligned_alloc needs size multiple of alignment
+   void* p = align ? std::aligned_alloc(align, (sz + align - 1) / align * align) : std::malloc(sz ? sz : 1);
+   if (!p)
+      throw std::bad_alloc();
+   return p;
+}
+
+static void countedFree(void* p) noexcept
+{
+   std::free(p);
+}
+
+void* operator new(std::size_t sz)
+{
+   return countedAlloc(sz);
+}
+
+void* operator new[](std::size_t sz)
+{
+   return countedAlloc(sz);
+}
+
+void* operator new(std::size_t sz, std::align_val_t al)
+{
+   return countedAlloc(sz, std::size_t(al));
+}
+
+void* operator new[](std::size_t sz, std::align_val_t al)
+{
+   return countedAlloc(sz, std::size_t(al));
+}
+
+void operator delete(void* p) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+   countedFree(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+   countedFree(p);
+}
+
+// allocation and memory counters of a benchmark run (started on construction)
+struct MemoryProbe
+{
+   std::size_t count0{ alloc_count.load() };
+   std::size_t bytes0{ alloc_bytes.load() };
+
+   MemoryProbe()
+   {
+      resetPeakRss();
+   }
+
+   void report(benchmark::State& state)
+   {
+      using benchmark::Counter;
+      state.counters["allocs"] = Counter(double(alloc_count.load() - count0), Counter::kAvgIterations);
+      state.counters["alloc_MB"] = Counter(double(alloc_bytes.load() - bytes0) / (1 << 20), Counter::kAvgIterations);
+      state.counters["peak_rss_MB"] = double(peakRssBytes()) / (1 << 20);
+   }
+};
+
+// keys of generated file, in file order (indexed once, outside of timing)
+static const std::vector<std::string>& fileKeys(Shape shape)
+{
+   static std::map<Shape, std::vector<std::string>> keys;
+   auto it = keys.find(shape);
+   if (it != keys.end())
+      return it->second;
+   std::vector<std::string>& out = keys[shape];
+   std::string path = dataFile(shape, benchMegabytes());
+   VastJSON bigj{ new std::ifstream(path), (shape == Shape::RootList) ? BIG_ROOT_LIST : BIG_ROOT_DICT_GENERIC };
+   if (shape == Shape::RootList) {
+      for (std::size_t i = 0; i < bigj.size(); i++)
+         out.push_back(std::to_string(i));
+   } else {
+      bigj.size();
+      for (auto it2 = bigj.beginCache(); it2 != bigj.endCache(); it2++)
+         out.push_back(it2->first);
+      // map order is not file order
+      std::sort(out.begin(), out.end(), [](const std::string& a, const std::string& b) {
+         return std::strtoull(a.c_str() + 1, nullptr, 10) < std::strtoull(b.c_str() + 1, nullptr, 10);
+      });
+   }
+   return out;
+}
+
+// index whole file (BIG_STRICT also parses everything)
+static void BM_Size(benchmark::State& state, Shape shape, ModeVastJSON mode, CacheVastJSON cacheMode)
+{
+   std::string path = dataFile(shape, benchMegabytes());
+   MemoryProbe probe;
+   std::size_t entries = 0;
+   for (auto _ : state) {
+      VastJSON bigj{ new std::ifstream(path), mode, cacheMode };
+      entries = bigj.size();
+      benchmark::DoNotOptimize(entries);
+   }
+   state.SetBytesProcessed(std::int64_t(state.iterations() * fileBytes(path)));
+   state.counters["entries"] = double(entries);
+   probe.report(state);
+}
+
+// open file and get first key (lazy modes only scan first entry)
+static void BM_FirstKey(benchmark::State& state, Shape shape, ModeVastJSON mode, CacheVastJSON cacheMode)
+{
+   std::string path = dataFile(shape, benchMegabytes());
+   const std::string& first = fileKeys(shape).front();
+   MemoryProbe probe;
+   for (auto _ : state) {
+      VastJSON bigj{ new std::ifstream(path), mode, cacheMode };
+      benchmark::DoNotOptimize(&bigj[first]);
+   }
+   probe.report(state);
+}
+
+// parse random entries of indexed file (each entry is moved back to string cache, untimed)
+static void BM_RandomGetKey(benchmark::State& state, Shape shape, ModeVastJSON mode, CacheVastJSON cacheMode)
+{
+   std::string path = dataFile(shape, benchMegabytes());
+   const std::vector<std::string>& keys = fileKeys(shape);
+   VastJSON bigj{ new std::ifstream(path), mode, cacheMode };
+   bigj.size();
+   std::mt19937_64 rng(1);
+   MemoryProbe probe;
+   for (auto _ : state) {
+      const std::string& key = keys[rng() % keys.size()];
+      benchmark::DoNotOptimize(&bigj[key]);
+      state.PauseTiming();
+      if (cacheMode == CACHE_OFFSET)
+         bigj.unload(key);
+      else
+         bigj.toCache(key);
+      state.ResumeTiming();
+   }
+   probe.report(state);
+}
+
+// parse random entry, then demote it: 'toCache' (re-serialized) on CACHE_STRING, 'unload' on CACHE_OFFSET
+static void BM_DemoteCycle(benchmark::State& state, Shape shape, ModeVastJSON mode, CacheVastJSON cacheMode)
+{
+   std::string path = dataFile(shape, benchMegabytes());
+   const std::vector<std::string>& keys = fileKeys(shape);
+   VastJSON bigj{ new std::ifstream(path), mode, cacheMode };
+   bigj.size();
+   std::mt19937_64 rng(1);
+   MemoryProbe probe;
+   for (auto _ : state) {
+      const std::string& key = keys[rng() % keys.size()];
+      benchmark::DoNotOptimize(&bigj[key]);
+      if (cacheMode == CACHE_OFFSET)
+         bigj.unload(key);
+      else
+         bigj.toCache(key);
+   }
+   probe.report(state);
+}
+
+static void registerAll()
+{
+   const Shape shapes[] = { Shape::RootDict, Shape::RootList, Shape::DeepNesting, Shape::StringHeavy, Shape::NumberHeavy };
+   for (Shape shape : shapes) {
+      // (mode, cache mode) pairs for shape
+      std::vector<std::pair<std::string, std::pair<ModeVastJSON, CacheVastJSON>>> modes;
+      if (shape == Shape::RootList)
+         modes = { { "BIG_ROOT_LIST", { BIG_ROOT_LIST, CACHE_STRING } },
+                   { "BIG_ROOT_LIST/CACHE_OFFSET", { BIG_ROOT_LIST, CACHE_OFFSET } } };
+      else
+         modes = { { "BIG_ROOT_DICT_GENERIC", { BIG_ROOT_DICT_GENERIC, CACHE_STRING } },
+                   { "BIG_ROOT_DICT_NO_ROOT_LIST", { BIG_ROOT_DICT_NO_ROOT_LIST, CACHE_STRING } },
+                   { "BIG_ROOT_DICT_GENERIC/CACHE_OFFSET", { BIG_ROOT_DICT_GENERIC, CACHE_OFFSET } },
+                   { "BIG_STRICT", { BIG_STRICT, CACHE_STRING } } };
+      for (auto& m : modes) {
+         std::string suffix = std::string("/") + shapeName(shape) + "/" + m.first;
+         ModeVastJSON mode = m.second.first;
+         CacheVastJSON cacheMode = m.second.second;
+         benchmark::RegisterBenchmark(("size" + suffix).c_str(), BM_Size, shape, mode, cacheMode)->Unit(benchmark::kMillisecond);
+         benchmark::RegisterBenchmark(("first_key" + suffix).c_str(), BM_FirstKey, shape, mode, cacheMode)->Unit(benchmark::kMicrosecond);
+         benchmark::RegisterBenchmark(("random_get_key" + suffix).c_str(), BM_RandomGetKey, shape, mode, cacheMode)->Unit(benchmark::kMicrosecond);
+         benchmark::RegisterBenchmark(("demote_cycle" + suffix).c_str(), BM_DemoteCycle, shape, mode, cacheMode)->Unit(benchmark::kMicrosecond);
+      }
+   }
+}
+
+// files are generated on first use (size is env VASTJSON_BENCH_MB, default 100),
+// so use '--benchmark_filter' to select shapes and modes
+int main(int argc, char** argv)
+{
+   benchmark::Initialize(&argc, argv);
+   if (benchmark::ReportUnrecognizedArguments(argc, argv))
+      return 1;
+   registerAll();
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+   return 0;
+}
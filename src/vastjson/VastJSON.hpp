@@ -11,13 +11,53 @@
 #error VastJSON must be included before nlohmann::json. See https://github.com/igormcoelho/vastjson/issues/4
 #endif
 
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <vector>
 //
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//
+#if !defined(VASTJSON_NO_SIMD) && defined(__AVX2__)
+#define VASTJSON_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(VASTJSON_NO_SIMD) && (defined(__SSE4_2__) || defined(__SSE2__))
+#define VASTJSON_SIMD_SSE
+#include <immintrin.h>
+#endif
+//
+// optional streaming decompression of input files (link with -lz / -lzstd)
+#ifdef VASTJSON_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef VASTJSON_WITH_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+//
 #include <iostream> // TODO REMOVE
 //
+#include <limits>
 #include <memory>
 
 namespace nlohmann {
@@ -75,14 +115,188 @@ input_adapter(std::shared_ptr<T>& stream_ptr)
 //using json = nlohmann::json;
 
 namespace vastjson {
+// block-buffered reader over any std::istream: stream is read in large blocks, and scanners move a pointer cursor
+// (refilling only at block boundaries), instead of paying a virtual (and sentry guarded) call per char.
+// methods follow std::istream names. note that stream is read ahead, so all scanning of a stream
+// must go through the same reader (and 'tellg()' is the logical position, not the position on stream).
+class BlockReader final
+{
+private:
+   std::istream* is;
+   std::unique_ptr<char[]> buf;
+   std::size_t capacity;
+   const char* cur{ nullptr };
+   const char* last{ nullptr };
+   // stream offset of buf[0]
+   std::uint64_t base{ 0 };
+   // stream has no more chars
+   bool exhausted{ false };
+
+   bool refill()
+   {
+      if (exhausted || !*is) {
+         exhausted = true;
+         return false;
+      }
+      base += last - buf.get();
+      is->read(buf.get(), capacity);
+      cur = buf.get();
+      last = buf.get() + is->gcount();
+      if (cur == last)
+         exhausted = true;
+      return cur != last;
+   }
+
+public:
+   static constexpr std::size_t BLOCK_SIZE = 1 << 16;
+
+   explicit BlockReader(std::istream* _is, std::size_t block_size = BLOCK_SIZE)
+     : is{ _is }
+     , buf{ new char[block_size] }
+     , capacity{ block_size }
+   {
+      cur = last = buf.get();
+      std::streampos start = is->tellg();
+      base = (start == std::streampos(-1)) ? 0 : std::uint64_t(start);
+   }
+
+   BlockReader(const BlockReader&) = delete;
+   BlockReader& operator=(const BlockReader&) = delete;
+
+   std::istream* stream() const
+   {
+      return is;
+   }
+
+   // heap bytes of block buffer
+   std::size_t footprint() const
+   {
+      return capacity;
+   }
+
+   // next char (or EOF)
+   int get()
+   {
+      if ((cur == last) && !refill())
+         return EOF;
+      return (unsigned char)*cur++;
+   }
+
+   bool get(char& c)
+   {
+      if ((cur == last) && !refill())
+         return false;
+      c = *cur++;
+      return true;
+   }
+
+   int peek()
+   {
+      if ((cur == last) && !refill())
+         return EOF;
+      return (unsigned char)*cur;
+   }
+
+   // put back last char (only right after a successful 'get()')
+   void unget()
+   {
+      cur--;
+   }
+
+   // consume everything
+   void ignore()
+   {
+      cur = last;
+      is->ignore(std::numeric_limits<std::streamsize>::max());
+      exhausted = true;
+   }
+
+   // keeps at least 'n' chars (up to block size) contiguous from cursor, moving rest of block to front
+   // (for block scanners); returns chars available from cursor, which is less than 'n' only at end of stream
+   std::size_t fill(std::size_t n)
+   {
+      std::size_t rest = last - cur;
+      n = std::min(n, capacity);
+      if ((rest >= n) || exhausted)
+         return rest;
+      base += cur - buf.get();
+      std::memmove(buf.get(), cur, rest);
+      cur = buf.get();
+      while ((rest < n) && *is) {
+         is->read(buf.get() + rest, capacity - rest);
+         rest += is->gcount();
+      }
+      last = cur + rest;
+      if (rest == 0)
+         exhausted = true;
+      return rest;
+   }
+
+   // chars from cursor (see 'fill()')
+   const char* current() const
+   {
+      return cur;
+   }
+
+   // consume 'n' chars from cursor (at most those given by 'fill()')
+   void skip(std::size_t n)
+   {
+      cur += n;
+   }
+
+   // reads line (with no '\n'), returning false if there's nothing left
+   bool getline(std::string& line)
+   {
+      line.clear();
+      if ((cur == last) && !refill())
+         return false;
+      while (true) {
+         const char* nl = static_cast<const char*>(std::memchr(cur, '\n', last - cur));
+         if (nl) {
+            line.append(cur, nl);
+            cur = nl + 1;
+            return true;
+         }
+         line.append(cur, last);
+         cur = last;
+         if (!refill())
+            return true;
+      }
+   }
+
+   // logical position on stream
+   std::uint64_t tellg() const
+   {
+      return base + (cur - buf.get());
+   }
+
+   // stream has been fully consumed (true only after trying to read past its end, as std::istream::eof())
+   bool eof() const
+   {
+      return exhausted && (cur == last);
+   }
+
+   // give back chars read ahead (seeking stream to logical position), if stream is seekable
+   void release()
+   {
+      if (cur == last)
+         return;
+      is->clear();
+      is->seekg(tellg());
+      cur = last;
+   }
+};
+
 // stream that caches stuff read by nlohmann::json
 struct CacheStream
 {
    using char_type = char;
-   std::istream* is;
+   BlockReader* is;
    std::string cache;
+   // stream has been exhausted
+   bool eof{ false };
 
-   CacheStream(std::istream* _is)
+   CacheStream(BlockReader* _is)
      : is(_is)
    {
    }
@@ -90,235 +304,2743 @@ struct CacheStream
    std::char_traits<char>::int_type get_character()
    {
       int c = is->get();
-      cache += c;
+      if (c == std::char_traits<char>::eof())
+         eof = true;
+      else
+         cache += c;
       return c;
    }
 };
 
-enum ModeVastJSON
+// input adapter (for nlohmann parser) reading through a CacheStream owned by caller
+struct CacheStreamRef
 {
-   // strategy for big dictionaries/objects on root level
-   BIG_ROOT_DICT_GENERIC = 0,
-   // strategy for big dictionaries/objects on root level (do not allow lists as top-level entries)
-   BIG_ROOT_DICT_NO_ROOT_LIST = 1,
-   // BIG_ROOT_LIST (TODO),
-   // BIG_TARGET_ELEMENT (TODO),
-   // NOT_BIG (TODO)
-   // strict mode fully checks integrity of json (not good for huge entries)
-   BIG_STRICT = 99
+   using char_type = char;
+   CacheStream* cs;
+
+   std::char_traits<char>::int_type get_character()
+   {
+      return cs->get_character();
+   }
 };
 
-//
-class VastJSON final
+// read-only stream buffer over existing memory (no copy, as opposed to std::istringstream)
+struct MemoryStreamBuf : public std::streambuf
+{
+   MemoryStreamBuf(const char* data, std::size_t size)
+   {
+      char* p = const_cast<char*>(data);
+      setg(p, p, p + size);
+   }
+};
+
+// base of decompressing stream buffers over a compressed file. tell and seek are supported (for CACHE_OFFSET):
+// forward seeks decompress until target, and backward seeks restart decoder from nearest restart point
+// (file start, unless format has independently decompressible frames)
+class DecompressStreamBuf : public std::streambuf
+{
+protected:
+   static constexpr std::size_t CHUNK = 1 << 16;
+   std::ifstream file;
+   std::unique_ptr<char[]> in{ new char[CHUNK] };
+   std::unique_ptr<char[]> out{ new char[CHUNK] };
+   // bytes of compressed input on 'in'
+   std::size_t in_len{ 0 };
+   // decompressed offset of out[0]
+   std::uint64_t out_base{ 0 };
+   // corrupted input (decompression stops)
+   bool failed{ false };
+
+   explicit DecompressStreamBuf(std::string path)
+     : file{ path, std::ios::binary }
+   {
+      setg(out.get(), out.get(), out.get());
+   }
+
+   // refill compressed input (false on end of file)
+   bool readInput()
+   {
+      file.read(in.get(), CHUNK);
+      in_len = file.gcount();
+      return in_len > 0;
+   }
+
+   // decompress next chars into 'out' (up to CHUNK), returning count (zero on end)
+   virtual std::size_t decompress() = 0;
+
+   // put decoder on a restart point at or before decompressed offset 'pos', returning its offset
+   virtual std::uint64_t restart(std::uint64_t pos) = 0;
+
+   int_type underflow() override
+   {
+      if (gptr() < egptr())
+         return traits_type::to_int_type(*gptr());
+      out_base += egptr() - eback();
+      std::size_t n = failed ? 0 : decompress();
+      setg(out.get(), out.get(), out.get() + n);
+      return n ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+   }
+
+   pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+   {
+      off_type cur = off_type(out_base + (gptr() - eback()));
+      if ((dir == std::ios_base::cur) && (off == 0))
+         return pos_type(cur); // tell
+      if (dir == std::ios_base::cur)
+         return seekpos(pos_type(cur + off), which);
+      if (dir == std::ios_base::beg)
+         return seekpos(pos_type(off), which);
+      return pos_type(off_type(-1)); // decompressed size is unknown
+   }
+
+   pos_type seekpos(pos_type sp, std::ios_base::openmode) override
+   {
+      if (off_type(sp) < 0)
+         return pos_type(off_type(-1));
+      std::uint64_t pos = std::uint64_t(off_type(sp));
+      if (pos < out_base) {
+         failed = false;
+         out_base = restart(pos);
+         setg(out.get(), out.get(), out.get());
+      }
+      // decompress forward, until 'pos' is on current chunk
+      while (pos > out_base + (egptr() - eback())) {
+         setg(eback(), egptr(), egptr());
+         if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+            return pos_type(off_type(-1));
+      }
+      setg(eback(), eback() + (pos - out_base), egptr());
+      return sp;
+   }
+
+public:
+   bool isOpen() const
+   {
+      return file.is_open();
+   }
+};
+
+#ifdef VASTJSON_WITH_ZLIB
+// gzip decompressing stream buffer (concatenated members are supported)
+class GzipStreamBuf final : public DecompressStreamBuf
 {
 private:
-   ModeVastJSON mode;
-   // multiple json
-   std::map<std::string, nlohmann::json> jsons;
-   // read string cache
-   std::map<std::string, std::string> cache;
-   // pending reads
-   std::unique_ptr<std::istream> ifsptr;
-   // count delimiters {} for ifsptr
-   // this variable was local, now it's global since stream consumption can be continued over ifsptr
-   int count_par_ifsptr = 0;
+   z_stream zs{};
+
+   std::size_t decompress() override
+   {
+      zs.next_out = reinterpret_cast<Bytef*>(out.get());
+      zs.avail_out = CHUNK;
+      while (zs.avail_out == CHUNK) {
+         if (zs.avail_in == 0) {
+            if (!readInput())
+               break;
+            zs.next_in = reinterpret_cast<Bytef*>(in.get());
+            zs.avail_in = in_len;
+         }
+         int ret = inflate(&zs, Z_NO_FLUSH);
+         if (ret == Z_STREAM_END)
+            inflateReset(&zs); // next member (if any)
+         else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+            failed = true;
+            break;
+         }
+      }
+      return CHUNK - zs.avail_out;
+   }
+
+   std::uint64_t restart(std::uint64_t) override
+   {
+      // no restart points on gzip: decompress again from file start
+      inflateReset(&zs);
+      zs.avail_in = 0;
+      file.clear();
+      file.seekg(0);
+      return 0;
+   }
 
 public:
-   void clear()
+   explicit GzipStreamBuf(std::string path)
+     : DecompressStreamBuf{ path }
    {
-      jsons.clear();
-      cache.clear();
-      ifsptr = nullptr;
-      count_par_ifsptr = 0;
+      // 16: gzip header
+      if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+         failed = true;
    }
 
-   std::istream& getIfsptr()
+   ~GzipStreamBuf()
    {
-      return *ifsptr;
+      inflateEnd(&zs);
    }
+};
+#endif
 
-   int& getCountParIfsptr()
+#ifdef VASTJSON_WITH_ZSTD
+// zstd decompressing stream buffer. for files on seekable format (with a seek table of frames, as written by
+// zstd 'contrib/seekable_format'), backward seeks only decompress the frame holding the target
+class ZstdStreamBuf final : public DecompressStreamBuf
+{
+private:
+   ZSTD_DCtx* dctx;
+   ZSTD_inBuffer zin{ nullptr, 0, 0 };
+   // compressed and decompressed offsets of each frame (empty if not seekable)
+   std::vector<std::pair<std::uint64_t, std::uint64_t>> frames;
+
+   static std::uint32_t readLE32(const unsigned char* p)
    {
-      return this->count_par_ifsptr;
+      return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
    }
 
-   // storing error flag here
-   bool hasError = false;
-   //
-   ModeVastJSON getMode()
+   // load seek table from skippable frame at end of file: entries (compressed size, decompressed size[, checksum]),
+   // then footer (number of frames, descriptor, seekable magic number)
+   void loadSeekTable()
    {
-      return mode;
+      file.seekg(0, std::ios::end);
+      std::int64_t fsize = file.tellg();
+      unsigned char footer[9];
+      if (fsize >= 17) {
+         file.seekg(fsize - 9);
+         file.read(reinterpret_cast<char*>(footer), 9);
+      }
+      if ((fsize >= 17) && file && (readLE32(footer + 5) == 0x8F92EAB1)) {
+         std::uint32_t nframes = readLE32(footer);
+         std::size_t entry = (footer[4] & 0x80) ? 12 : 8;
+         std::int64_t table = std::int64_t(nframes) * entry;
+         if (fsize >= table + 17) {
+            std::vector<unsigned char> data(table);
+            file.seekg(fsize - 9 - table);
+            file.read(reinterpret_cast<char*>(data.data()), table);
+            std::uint64_t c = 0, d = 0;
+            for (std::uint32_t i = 0; file && (i < nframes); i++) {
+               frames.emplace_back(c, d);
+               c += readLE32(&data[i * entry]);
+               d += readLE32(&data[i * entry + 4]);
+            }
+         }
+      }
+      file.clear();
+      file.seekg(0);
    }
 
-   const auto begin() const
+   std::size_t decompress() override
    {
-      // force compute cache
-      size();
-      // cache is now complete
-      return cache.begin();
+      ZSTD_outBuffer zout{ out.get(), CHUNK, 0 };
+      while (zout.pos == 0) {
+         if (zin.pos == zin.size) {
+            if (!readInput())
+               break;
+            zin = ZSTD_inBuffer{ in.get(), in_len, 0 };
+         }
+         // skippable frames (such as seek table) are ignored by decoder
+         if (ZSTD_isError(ZSTD_decompressStream(dctx, &zout, &zin))) {
+            failed = true;
+            break;
+         }
+      }
+      return zout.pos;
    }
 
-   const auto end() const
+   std::uint64_t restart(std::uint64_t pos) override
    {
-      return cache.end();
+      // last frame starting at or before 'pos'
+      auto it = std::upper_bound(frames.begin(), frames.end(), pos, [](std::uint64_t p, const std::pair<std::uint64_t, std::uint64_t>& f) {
+         return p < f.second;
+      });
+      std::pair<std::uint64_t, std::uint64_t> start{ 0, 0 };
+      if (it != frames.begin())
+         start = *(it - 1);
+      ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+      zin = ZSTD_inBuffer{ nullptr, 0, 0 };
+      file.clear();
+      file.seekg(start.first);
+      return start.second;
    }
 
-   const auto beginCache() const
+public:
+   explicit ZstdStreamBuf(std::string path)
+     : DecompressStreamBuf{ path }
+     , dctx{ ZSTD_createDCtx() }
    {
-      // cache may not be complete
-      return cache.begin();
+      if (file)
+         loadSeekTable();
    }
 
-   const auto endCache() const
+   ~ZstdStreamBuf()
    {
-      return cache.end();
+      ZSTD_freeDCtx(dctx);
    }
 
-   bool isPending() const
+   // number of independently decompressible frames (zero if file is not on seekable format)
+   std::size_t seekableFrames() const
    {
-      return ifsptr != nullptr;
+      return frames.size();
    }
+};
+#endif
 
-   // cached items size. Note that: cacheSize() <= size()
-   unsigned cacheSize() const
+// input stream owning its stream buffer
+class BufferedIstream final : public std::istream
+{
+private:
+   std::unique_ptr<std::streambuf> buf;
+
+public:
+   explicit BufferedIstream(std::unique_ptr<std::streambuf> _buf)
+     : std::istream{ nullptr }
+     , buf{ std::move(_buf) }
    {
-      return this->cache.size();
+      rdbuf(buf.get());
    }
+};
 
-   // return number of top-level entries (not REALLY const...)
-   unsigned size() const
+// opens file for lazy processing, with transparent streaming decompression of gzip and zstd files (detected by magic bytes).
+// compressed files require building with VASTJSON_WITH_ZLIB / VASTJSON_WITH_ZSTD (otherwise, a failed stream is returned)
+inline std::unique_ptr<std::istream>
+openFile(std::string path)
+{
+   unsigned char magic[4]{ 0, 0, 0, 0 };
    {
-      if (ifsptr) {
-         // sorry, this is quite fake, but necessary!
-         // I know what I'm doing!
-         VastJSON* me = const_cast<VastJSON*>(this);
-         //
-         // must cache all available entries (to calculate 'size()')
-         me->cacheUntil(*me->ifsptr, me->count_par_ifsptr);
-         // stream has been consumed, drop its memory pointer
-         me->ifsptr = std::unique_ptr<std::ifstream>();
+      std::ifstream probe(path, std::ios::binary);
+      probe.read(reinterpret_cast<char*>(magic), 4);
+   }
+   bool gzip = (magic[0] == 0x1F) && (magic[1] == 0x8B);
+   // zstd frame (28 B5 2F FD), or skippable frame (5? 2A 4D 18)
+   bool zstd = ((magic[0] == 0x28) && (magic[1] == 0xB5) && (magic[2] == 0x2F) && (magic[3] == 0xFD)) ||
+               (((magic[0] & 0xF0) == 0x50) && (magic[1] == 0x2A) && (magic[2] == 0x4D) && (magic[3] == 0x18));
+   std::unique_ptr<std::istream> is;
+   if (gzip) {
+#ifdef VASTJSON_WITH_ZLIB
+      is.reset(new BufferedIstream(std::unique_ptr<std::streambuf>(new GzipStreamBuf(path))));
+#else
+      std::cerr << "WARNING: VastJSON built without VASTJSON_WITH_ZLIB cannot read '" << path << "'" << std::endl;
+      is.reset(new std::ifstream());
+      is->setstate(std::ios::failbit);
+#endif
+   } else if (zstd) {
+#ifdef VASTJSON_WITH_ZSTD
+      is.reset(new BufferedIstream(std::unique_ptr<std::streambuf>(new ZstdStreamBuf(path))));
+#else
+      std::cerr << "WARNING: VastJSON built without VASTJSON_WITH_ZSTD cannot read '" << path << "'" << std::endl;
+      is.reset(new std::ifstream());
+      is->setstate(std::ios::failbit);
+#endif
+   } else
+      is.reset(new std::ifstream(path));
+   return is;
+}
+
+// read-only memory mapping of a whole file (empty and not open on failure)
+class MappedFile final
+{
+private:
+   std::string path;
+   const char* mdata{ nullptr };
+   std::size_t msize{ 0 };
+   // modification time (nanoseconds since epoch)
+   std::int64_t mtime{ 0 };
+   bool open{ false };
+
+public:
+   explicit MappedFile(std::string _path)
+     : path{ _path }
+   {
+#ifndef _WIN32
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+         return;
+      struct stat st;
+      if (::fstat(fd, &st) == 0) {
+         msize = st.st_size;
+#ifdef __APPLE__
+         mtime = std::int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+         mtime = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+         open = true;
+         if (msize > 0) {
+            void* addr = ::mmap(nullptr, msize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+               msize = 0;
+               open = false;
+            } else {
+               mdata = static_cast<const char*>(addr);
+               // top-level indexing is a forward scan
+               ::madvise(addr, msize, MADV_SEQUENTIAL);
+            }
+         }
       }
+      ::close(fd);
+#endif
+   }
 
-      return this->cache.size();
+   ~MappedFile()
+   {
+#ifndef _WIN32
+      if (mdata)
+         ::munmap(const_cast<char*>(mdata), msize);
+#endif
    }
 
-   // public method: advance on stream until 'targetKey' key is found, or 'count_keys' keys are found
-   void getUntil(std::string targetKey = "", int count_keys = -1)
+   // delete because of pointer members
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+   MappedFile& operator=(MappedFile&&) = delete;
+
+   MappedFile(MappedFile&& rhs) noexcept
+     : path{ std::move(rhs.path) }
+     , mdata{ rhs.mdata }
+     , msize{ rhs.msize }
+     , mtime{ rhs.mtime }
+     , open{ rhs.open }
    {
-      if (ifsptr) {
-         // must cache all available entries (to calculate 'size()')
-         cacheUntil(*ifsptr, count_par_ifsptr, targetKey, count_keys);
+      rhs.mdata = nullptr;
+      rhs.msize = 0;
+      rhs.open = false;
+   }
 
-         // IF stream has been consumed, drop its memory pointer
-         if (ifsptr->eof())
-            ifsptr = std::unique_ptr<std::ifstream>();
-      }
+   bool isOpen() const
+   {
+      return open;
    }
 
-   // gets key json
-   nlohmann::json& operator[](std::string key)
+   const std::string& getPath() const
    {
-      return this->getKey(key);
+      return path;
    }
 
-   // gets key json (not REALLY const...)
-   const nlohmann::json& operator[](std::string key) const
+   const char* data() const
    {
-      return this->getKey(key);
+      return mdata;
+   }
+
+   std::size_t size() const
+   {
+      return msize;
+   }
+
+   std::string_view view() const
+   {
+      return std::string_view(mdata, msize);
+   }
+
+   std::int64_t getMTime() const
+   {
+      return mtime;
+   }
+
+   // FNV-1a hash of size, first and last 4KB (cheap validation, not a full file hash)
+   std::uint64_t sampleHash() const
+   {
+      std::uint64_t h = 14695981039346656037ULL;
+      auto add = [&h](unsigned char c) {
+         h ^= c;
+         h *= 1099511628211ULL;
+      };
+      for (int i = 0; i < 8; i++)
+         add((unsigned char)(msize >> (8 * i)));
+      const std::size_t SAMPLE = 4096;
+      for (std::size_t i = 0; i < std::min(msize, SAMPLE); i++)
+         add(mdata[i]);
+      for (std::size_t i = (msize > SAMPLE) ? msize - SAMPLE : 0; i < msize; i++)
+         add(mdata[i]);
+      return h;
+   }
+};
+
+// finds structural chars (quotes, braces, brackets, colons and commas) outside strings on 64-byte blocks
+// (in the style of simdjson stage 1: SSE/AVX2 classification, with scalar fallback)
+class StructuralIndexer final
+{
+private:
+   // all ones if previous block ended inside a string
+   std::uint64_t prev_in_string{ 0 };
+   // one if first char of next block is escaped
+   std::uint64_t prev_escaped{ 0 };
+
+public:
+   static constexpr std::size_t BLOCK_SIZE = 64;
+
+   // starts outside strings (or inside a string, for speculative chunk scans)
+   explicit StructuralIndexer(bool in_string = false)
+     : prev_in_string{ in_string ? ~std::uint64_t(0) : 0 }
+   {
+   }
+
+   // true if last block ended inside a string
+   bool inString() const
+   {
+      return prev_in_string != 0;
+   }
+
+   static int trailingZeros(std::uint64_t bits)
+   {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctzll(bits);
+#else
+      int n = 0;
+      while (!(bits & 1)) {
+         bits >>= 1;
+         n++;
+      }
+      return n;
+#endif
+   }
+
+   // one bit per byte of 64-byte block, for quotes, backslashes and operators {}[]:,
+   static void classify(const char* block, std::uint64_t& quote, std::uint64_t& backslash, std::uint64_t& op)
+   {
+#if defined(VASTJSON_SIMD_AVX2)
+      quote = backslash = op = 0;
+      for (int i = 0; i < 2; i++) {
+         __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+         __m256i ops = _mm256_or_si256(
+           _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}'))),
+           _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']'))),
+                           _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')))));
+         quote |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))))) << (32 * i);
+         backslash |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))))) << (32 * i);
+         op |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(ops))) << (32 * i);
+      }
+#elif defined(VASTJSON_SIMD_SSE)
+      quote = backslash = op = 0;
+      for (int i = 0; i < 4; i++) {
+         __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+         __m128i ops = _mm_or_si128(
+           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+           _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(',')))));
+         quote |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << (16 * i);
+         backslash |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << (16 * i);
+         op |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(ops))) << (16 * i);
+      }
+#else
+      quote = backslash = op = 0;
+      for (std::size_t i = 0; i < BLOCK_SIZE; i++) {
+         char c = block[i];
+         std::uint64_t bit = std::uint64_t(1) << i;
+         if (c == '"')
+            quote |= bit;
+         else if (c == '\\')
+            backslash |= bit;
+         else if ((c == '{') || (c == '}') || (c == '[') || (c == ']') || (c == ':') || (c == ','))
+            op |= bit;
+      }
+#endif
+   }
+
+   // bits of chars escaped by a backslash (odd-length backslash sequences), carried over blocks
+   std::uint64_t findEscaped(std::uint64_t backslash)
+   {
+      // if there was overflow, first char is escaped (and cannot start a sequence)
+      backslash &= ~prev_escaped;
+      std::uint64_t follows_escape = (backslash << 1) | prev_escaped;
+      // get sequences starting on even bits by clearing out the odd series using +
+      const std::uint64_t even_bits = 0x5555555555555555ULL;
+      std::uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+      std::uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+      prev_escaped = (sequences_starting_on_even_bits < backslash) ? 1 : 0; // overflow
+      std::uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+      return (even_bits ^ invert_mask) & follows_escape;
+   }
+
+   // bit i is the xor of bits [0..i] (marks bytes inside strings, from opening quote)
+   static std::uint64_t prefixXor(std::uint64_t bits)
+   {
+#if defined(__PCLMUL__) && !defined(VASTJSON_NO_SIMD)
+      __m128i all_ones = _mm_set1_epi8('\xFF');
+      __m128i result = _mm_clmulepi64_si128(_mm_set_epi64x(0ULL, bits), all_ones, 0);
+      return std::uint64_t(_mm_cvtsi128_si64(result));
+#else
+      bits ^= bits << 1;
+      bits ^= bits << 2;
+      bits ^= bits << 4;
+      bits ^= bits << 8;
+      bits ^= bits << 16;
+      bits ^= bits << 32;
+      return bits;
+#endif
+   }
+
+   // structural bits of next 64-byte block: operators outside strings, and all unescaped quotes
+   std::uint64_t next(const char* block)
+   {
+      std::uint64_t quote, backslash, op;
+      classify(block, quote, backslash, op);
+      quote &= ~findEscaped(backslash);
+      std::uint64_t in_string = prefixXor(quote) ^ prev_in_string;
+      prev_in_string = std::uint64_t(std::int64_t(in_string) >> 63);
+      return (op & ~in_string) | quote;
+   }
+};
+
+// runs 'fn(i)' for i in [0, count) over 'nthreads' worker threads (0 means hardware concurrency)
+inline void
+parallelFor(std::size_t count, unsigned nthreads, std::function<void(std::size_t)> fn)
+{
+   if (nthreads == 0)
+      nthreads = std::max(1u, std::thread::hardware_concurrency());
+   nthreads = unsigned(std::min<std::size_t>(nthreads, count));
+   if (nthreads <= 1) {
+      for (std::size_t i = 0; i < count; i++)
+         fn(i);
+      return;
+   }
+   std::atomic<std::size_t> next{ 0 };
+   std::vector<std::thread> workers;
+   for (unsigned t = 0; t < nthreads; t++)
+      workers.emplace_back([&]() {
+         for (std::size_t i = next++; i < count; i = next++)
+            fn(i);
+      });
+   for (auto& w : workers)
+      w.join();
+}
+
+// resumable top-level scan over structural chars (key/value boundaries on depth 1)
+struct RootScanState
+{
+   StructuralIndexer indexer;
+   // root has been detected
+   bool started{ false };
+   // offset of next block to be indexed, and offset of current block
+   std::size_t next_block{ 0 };
+   std::size_t block{ 0 };
+   // pending structural bits of current block
+   std::uint64_t bits{ 0 };
+   int depth{ 0 };
+   // 0: key opening quote; 1: key closing quote; 2: colon; 3: value
+   int step{ 0 };
+   std::size_t key_begin{ 0 };
+   std::string key;
+   std::size_t value_begin{ 0 };
+};
+
+// node overhead of std::map (color, parent, left, right)
+constexpr std::size_t MAP_NODE = 4 * sizeof(void*);
+
+// heap bytes of string (zero if its chars are inside the object, by small string optimization)
+inline std::size_t stringHeap(const std::string& str)
+{
+   const char* self = reinterpret_cast<const char*>(&str);
+   bool inside = (str.data() >= self) && (str.data() < self + sizeof(std::string));
+   return inside ? 0 : str.capacity() + 1;
+}
+
+// estimated heap footprint (in bytes) of a parsed json value
+inline std::size_t jsonFootprint(const nlohmann::json& j)
+{
+   std::size_t n = sizeof(nlohmann::json);
+   switch (j.type()) {
+      case nlohmann::json::value_t::object:
+         n += sizeof(nlohmann::json::object_t);
+         for (auto& kv : j.get_ref<const nlohmann::json::object_t&>()) {
+            n += MAP_NODE + sizeof(std::string) + stringHeap(kv.first);
+            n += jsonFootprint(kv.second);
+         }
+         break;
+      case nlohmann::json::value_t::array: {
+         auto& arr = j.get_ref<const nlohmann::json::array_t&>();
+         n += sizeof(nlohmann::json::array_t) + (arr.capacity() - arr.size()) * sizeof(nlohmann::json);
+         for (auto& e : arr)
+            n += jsonFootprint(e);
+         break;
+      }
+      case nlohmann::json::value_t::string: {
+         auto& str = j.get_ref<const nlohmann::json::string_t&>();
+         n += sizeof(std::string) + stringHeap(str);
+         break;
+      }
+      default:
+         break;
+   }
+   return n;
+}
+
+// memory held by top-level entries (in bytes), per tier (see 'memoryUsage()')
+struct MemoryVastJSON
+{
+   // string cache (heap of raw text)
+   std::size_t cache{ 0 };
+   // compressed string cache
+   std::size_t packed{ 0 };
+   // parsed json (estimated, as 'jsonFootprint()')
+   std::size_t json{ 0 };
+   // keys and map nodes of all tiers (string cache, offsets, parsed json, compressed and spilled entries)
+   std::size_t keys{ 0 };
+   // structures not owned by any entry: flat index, memory budget bookkeeping, read buffers (zero for single entries)
+   std::size_t other{ 0 };
+   // bytes on spill file (not in memory, so not on 'total()')
+   std::size_t spilled{ 0 };
+
+   std::size_t total() const
+   {
+      return cache + packed + json + keys + other;
+   }
+};
+
+// recency of parsed entries, for memory budget (see 'setMemoryBudget()')
+struct LruState
+{
+   // max bytes of parsed json (zero means unlimited)
+   std::size_t budget{ 0 };
+   // estimated bytes of parsed json currently tracked
+   std::size_t used{ 0 };
+   // keys, from most to least recently used
+   std::list<std::string> order;
+   // position on 'order' and estimated footprint of each parsed key
+   std::map<std::string, std::pair<std::list<std::string>::iterator, std::size_t>, std::less<>> where;
+
+   // forget tracked entries (budget is kept)
+   void clear()
+   {
+      used = 0;
+      order.clear();
+      where.clear();
+   }
+};
+
+// background indexer of pending source (see 'startPrefetch()')
+struct PrefetchState
+{
+   std::thread worker;
+   // guards all tiers while worker is alive (recursive: public methods call each other)
+   std::recursive_mutex mtx;
+   // notified whenever a batch of keys is published (or source is finished)
+   std::condition_variable_any published;
+   std::atomic<bool> stop{ false };
+   // source is fully indexed (or indexing was stopped)
+   bool done{ false };
+};
+
+// parsed entry shared by concurrent readers (see 'enableConcurrentReads()')
+struct ConcurrentSlot
+{
+   // entry is parsed exactly once
+   std::once_flag once;
+   nlohmann::json value;
+   // parsed json (on 'value', or on entry loaded before concurrent mode)
+   nlohmann::json* parsed{ nullptr };
+};
+
+// state of concurrent read mode
+struct ConcurrentState
+{
+   // one slot per top-level key (never changed after creation, so lookups need no lock)
+   std::map<std::string, ConcurrentSlot, std::less<>> slots;
+   // serializes re-reads from source stream (only for CACHE_OFFSET without mapped file)
+   std::mutex stream_mtx;
+   // memory budget, suspended while in concurrent mode
+   std::size_t budget{ 0 };
+};
+
+// snapshot of work counters (see 'enableStats()'). times are from a monotonic clock, in nanoseconds
+// (summed over threads, for parallel parsing), and byte sizes of parsed json are estimated.
+struct StatsVastJSON
+{
+   // bytes consumed from source (stream or mapped file) while indexing
+   std::uint64_t bytes_scanned{ 0 };
+   // top-level entries indexed
+   std::uint64_t entries_indexed{ 0 };
+   // parses of top-level entries, and their input bytes
+   std::uint64_t parse_calls{ 0 };
+   std::uint64_t parse_bytes{ 0 };
+   // accesses to top-level entries already parsed (hits), or parsed on access (misses)
+   std::uint64_t cache_hits{ 0 };
+   std::uint64_t cache_misses{ 0 };
+   // parsed entries demoted by memory budget
+   std::uint64_t evictions{ 0 };
+   // re-serializations of parsed entries (by 'toCache()')
+   std::uint64_t serializations{ 0 };
+   // time indexing (scanning and key extraction), parsing entries, and re-serializing entries
+   std::uint64_t scan_ns{ 0 };
+   std::uint64_t parse_ns{ 0 };
+   std::uint64_t serialize_ns{ 0 };
+   // bytes held in string cache (plain or compressed) and parsed json: current, and peak
+   std::size_t cache_bytes{ 0 };
+   std::size_t peak_cache_bytes{ 0 };
+   std::size_t json_bytes{ 0 };
+   std::size_t peak_json_bytes{ 0 };
+};
+
+// live work counters (updated by worker threads too)
+struct StatsState
+{
+   std::atomic<std::uint64_t> bytes_scanned{ 0 };
+   std::atomic<std::uint64_t> entries_indexed{ 0 };
+   std::atomic<std::uint64_t> parse_calls{ 0 };
+   std::atomic<std::uint64_t> parse_bytes{ 0 };
+   std::atomic<std::uint64_t> cache_hits{ 0 };
+   std::atomic<std::uint64_t> cache_misses{ 0 };
+   std::atomic<std::uint64_t> evictions{ 0 };
+   std::atomic<std::uint64_t> serializations{ 0 };
+   std::atomic<std::uint64_t> scan_ns{ 0 };
+   std::atomic<std::uint64_t> parse_ns{ 0 };
+   std::atomic<std::uint64_t> serialize_ns{ 0 };
+   std::atomic<std::size_t> peak_cache_bytes{ 0 };
+   std::atomic<std::size_t> peak_json_bytes{ 0 };
+
+   static void raise(std::atomic<std::size_t>& peak, std::size_t value)
+   {
+      std::size_t old = peak.load();
+      while ((old < value) && !peak.compare_exchange_weak(old, value)) {
+      }
+   }
+};
+
+// adds time elapsed until destruction to 'ns' (nothing, if null)
+class StatsTimer final
+{
+private:
+   std::atomic<std::uint64_t>* ns;
+   std::chrono::steady_clock::time_point start;
+
+public:
+   explicit StatsTimer(std::atomic<std::uint64_t>* _ns)
+     : ns{ _ns }
+   {
+      if (ns)
+         start = std::chrono::steady_clock::now();
+   }
+
+   ~StatsTimer()
+   {
+      if (ns)
+         *ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+   }
+};
+
+// navigation state towards target element (for BIG_TARGET_ELEMENT)
+struct TargetState
+{
+   // reference tokens of json pointer
+   std::vector<std::string> tokens;
+   // open char ('{' or '[') and next position of containers on path
+   std::vector<char> containers;
+   std::vector<std::size_t> indices;
+   // 0: before target; 1: inside target; 2: after target
+   int stage{ 0 };
+   // target is a list (entries are keyed by position, as BIG_ROOT_LIST)
+   bool list{ false };
+   // json outside target element (target itself is null)
+   nlohmann::json outer;
+};
+
+enum ModeVastJSON
+{
+   // strategy for big dictionaries/objects on root level
+   BIG_ROOT_DICT_GENERIC = 0,
+   // strategy for big dictionaries/objects on root level (do not allow lists as top-level entries)
+   BIG_ROOT_DICT_NO_ROOT_LIST = 1,
+   // strategy for big lists on root level (entries are keyed by position: "0", "1", ...)
+   BIG_ROOT_LIST = 2,
+   // strategy for big dictionary/object (or list, keyed by position) on a target json pointer (such as "/data"), and small siblings elsewhere
+   BIG_TARGET_ELEMENT = 3,
+   // strategy for newline-delimited json (JSON Lines), one entry per line (keyed by position: "0", "1", ...)
+   BIG_JSON_LINES = 4,
+   // NOT_BIG (TODO)
+   // strict mode fully checks integrity of json (throws 'nlohmann::json::parse_error' on bad syntax)
+   BIG_STRICT = 99
+};
+
+enum CacheVastJSON
+{
+   // top-level entries are copied into string cache (works for any stream)
+   CACHE_STRING = 0,
+   // top-level entries only record byte offsets, and are re-read from stream on demand (requires seekable stream)
+   CACHE_OFFSET = 1
+};
+
+// compressor of string cache entries: zstd (optionally with a shared dictionary, trained from sample entries),
+// or zlib (if only VASTJSON_WITH_ZLIB is defined). decompression is thread-safe.
+class CacheCodec final
+{
+private:
+   int level;
+#ifdef VASTJSON_WITH_ZSTD
+   ZSTD_CCtx* cctx{ ZSTD_createCCtx() };
+   ZSTD_CDict* cdict{ nullptr };
+   ZSTD_DDict* ddict{ nullptr };
+#endif
+
+public:
+   // some codec is built in
+   static bool available()
+   {
+#if defined(VASTJSON_WITH_ZSTD) || defined(VASTJSON_WITH_ZLIB)
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   // dictionary of 'dict_size' bytes is trained from 'samples' (only for zstd, and zero means no dictionary)
+   CacheCodec(int _level, const std::vector<std::string_view>& samples, std::size_t dict_size)
+     : level{ _level }
+   {
+#ifdef VASTJSON_WITH_ZSTD
+      if ((dict_size > 0) && !samples.empty()) {
+         std::string all;
+         std::vector<std::size_t> sizes;
+         for (auto& sample : samples) {
+            all.append(sample.data(), sample.length());
+            sizes.push_back(sample.length());
+         }
+         std::string dict(dict_size, '\0');
+         std::size_t n = ZDICT_trainFromBuffer(&dict[0], dict.length(), all.data(), sizes.data(), unsigned(sizes.size()));
+         // training fails for too few (or too small) samples: no dictionary then
+         if (!ZDICT_isError(n)) {
+            cdict = ZSTD_createCDict(dict.data(), n, level);
+            ddict = ZSTD_createDDict(dict.data(), n);
+         }
+      }
+#else
+      (void)samples;
+      (void)dict_size;
+#endif
+   }
+
+   ~CacheCodec()
+   {
+#ifdef VASTJSON_WITH_ZSTD
+      ZSTD_freeCCtx(cctx);
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+#endif
+   }
+
+   CacheCodec(const CacheCodec&) = delete;
+   CacheCodec& operator=(const CacheCodec&) = delete;
+
+   bool hasDictionary() const
+   {
+#ifdef VASTJSON_WITH_ZSTD
+      return cdict != nullptr;
+#else
+      return false;
+#endif
+   }
+
+   std::string compress(std::string_view raw)
+   {
+#if defined(VASTJSON_WITH_ZSTD)
+      std::string packed(ZSTD_compressBound(raw.length()), '\0');
+      std::size_t n = cdict ? ZSTD_compress_usingCDict(cctx, &packed[0], packed.length(), raw.data(), raw.length(), cdict)
+                            : ZSTD_compressCCtx(cctx, &packed[0], packed.length(), raw.data(), raw.length(), level);
+      packed.resize(ZSTD_isError(n) ? 0 : n);
+#elif defined(VASTJSON_WITH_ZLIB)
+      // original size (8 bytes) and deflated data
+      uLongf n = compressBound(raw.length());
+      std::string packed(8 + n, '\0');
+      for (int i = 0; i < 8; i++)
+         packed[i] = char((std::uint64_t(raw.length()) >> (8 * i)) & 0xFF);
+      int ret = compress2(reinterpret_cast<Bytef*>(&packed[8]), &n, reinterpret_cast<const Bytef*>(raw.data()), raw.length(), std::min(level, 9));
+      packed.resize((ret == Z_OK) ? 8 + n : 0);
+#else
+      std::string packed(raw);
+#endif
+      packed.shrink_to_fit();
+      return packed;
+   }
+
+   std::string decompress(std::string_view packed) const
+   {
+#if defined(VASTJSON_WITH_ZSTD)
+      thread_local std::unique_ptr<ZSTD_DCtx, std::size_t (*)(ZSTD_DCtx*)> dctx{ ZSTD_createDCtx(), ZSTD_freeDCtx };
+      unsigned long long size = ZSTD_getFrameContentSize(packed.data(), packed.length());
+      if ((size == ZSTD_CONTENTSIZE_ERROR) || (size == ZSTD_CONTENTSIZE_UNKNOWN))
+         return "";
+      std::string raw(size, '\0');
+      std::size_t n = ddict ? ZSTD_decompress_usingDDict(dctx.get(), &raw[0], raw.length(), packed.data(), packed.length(), ddict)
+                            : ZSTD_decompressDCtx(dctx.get(), &raw[0], raw.length(), packed.data(), packed.length());
+      if (ZSTD_isError(n))
+         return "";
+      return raw;
+#elif defined(VASTJSON_WITH_ZLIB)
+      if (packed.length() < 8)
+         return "";
+      std::uint64_t size = 0;
+      for (int i = 0; i < 8; i++)
+         size |= std::uint64_t((unsigned char)packed[i]) << (8 * i);
+      std::string raw(size, '\0');
+      uLongf n = size;
+      if (uncompress(reinterpret_cast<Bytef*>(&raw[0]), &n, reinterpret_cast<const Bytef*>(packed.data() + 8), packed.length() - 8) != Z_OK)
+         return "";
+      return raw;
+#else
+      return std::string(packed);
+#endif
+   }
+};
+
+// byte range [begin, end) of a top-level entry on its source stream
+struct ByteRange
+{
+   std::uint64_t begin{ 0 };
+   std::uint64_t end{ 0 };
+
+   std::uint64_t length() const
+   {
+      return end - begin;
+   }
+};
+
+// order of top-level keys on string cache: by string, or by position for list modes ("2" before "10")
+struct KeyOrder
+{
+   using is_transparent = void;
+   bool by_position{ false };
+
+   bool operator()(std::string_view a, std::string_view b) const
+   {
+      if (by_position && (a.length() != b.length()))
+         return a.length() < b.length();
+      return a < b;
+   }
+};
+
+// segment file of string cache entries spilled out of memory (see 'setSpillThreshold()')
+struct SpillState
+{
+   // max bytes of string cache kept in memory (zero stops spilling)
+   std::size_t threshold{ 0 };
+   // anonymous temporary file (removed when closed)
+   std::FILE* file{ nullptr };
+   // bytes written on segment
+   std::uint64_t size{ 0 };
+   // byte range of each spilled entry on segment
+   std::map<std::string, ByteRange, std::less<>> ranges;
+   // freed extents of segment (begin -> end), reused by next appends
+   std::map<std::uint64_t, std::uint64_t> holes;
+   // serializes file position (readers may be worker threads)
+   std::mutex mtx;
+
+   ~SpillState()
+   {
+      if (file)
+         std::fclose(file);
+   }
+
+   // creates segment on 'dir' (or system temp dir, if empty)
+   bool open(const std::string& dir)
+   {
+      if (dir.empty())
+         file = std::tmpfile();
+#ifndef _WIN32
+      else {
+         std::string path = dir + "/vastjson-spill-XXXXXX";
+         int fd = ::mkstemp(&path[0]);
+         if (fd >= 0) {
+            ::unlink(path.c_str()); // file lives while open
+            file = ::fdopen(fd, "w+b");
+            if (!file)
+               ::close(fd);
+         }
+      }
+#endif
+      return file != nullptr;
+   }
+
+   // 64-bit file position (segment may exceed 2GB)
+   bool seek(std::uint64_t pos)
+   {
+#ifndef _WIN32
+      return ::fseeko(file, off_t(pos), SEEK_SET) == 0;
+#else
+      return ::_fseeki64(file, __int64(pos), SEEK_SET) == 0;
+#endif
+   }
+
+   // writes raw entry on first freed extent that fits it (or at end of segment)
+   bool append(const std::string& raw, ByteRange& range)
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      std::uint64_t pos = size;
+      auto hole = holes.begin();
+      while ((hole != holes.end()) && (hole->second - hole->first < raw.length()))
+         ++hole;
+      if (hole != holes.end())
+         pos = hole->first;
+      if (!seek(pos) || (std::fwrite(raw.data(), 1, raw.length(), file) != raw.length()))
+         return false;
+      range.begin = pos;
+      range.end = pos + raw.length();
+      if (hole != holes.end()) {
+         std::uint64_t end = hole->second;
+         holes.erase(hole);
+         if (range.end < end)
+            holes[range.end] = end;
+      } else
+         size = range.end;
+      return true;
+   }
+
+   std::string read(const ByteRange& range)
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      std::string raw(range.length(), '\0');
+      if (!seek(range.begin) || (std::fread(&raw[0], 1, raw.length(), file) != raw.length()))
+         raw.clear();
+      return raw;
+   }
+
+   // forget entry of key, keeping its extent for reuse (merged with adjacent holes)
+   void release(std::string_view key)
+   {
+      auto it = ranges.find(key);
+      if (it == ranges.end())
+         return;
+      std::uint64_t begin = it->second.begin;
+      std::uint64_t end = it->second.end;
+      ranges.erase(it);
+      std::lock_guard<std::mutex> lock(mtx);
+      auto next = holes.lower_bound(begin);
+      if ((next != holes.end()) && (next->first == end)) {
+         end = next->second;
+         next = holes.erase(next);
+      }
+      if ((next != holes.begin()) && (std::prev(next)->second == begin)) {
+         begin = std::prev(next)->first;
+         holes.erase(std::prev(next));
+      }
+      if (end == size)
+         size = begin; // tail is free again
+      else
+         holes[begin] = end;
+   }
+
+   // forget all entries (segment space is reused)
+   void clear()
+   {
+      ranges.clear();
+      holes.clear();
+      size = 0;
+   }
+};
+
+// entry of flat key index: key (on arena), and pointers to entry on each tier (null if absent)
+struct IndexEntry
+{
+   std::size_t key_offset{ 0 };
+   std::size_t key_length{ 0 };
+   std::size_t hash{ 0 };
+   // string cache (always present for indexed keys)
+   std::string* cached{ nullptr };
+   // byte range on source (only for CACHE_OFFSET)
+   const ByteRange* range{ nullptr };
+   // parsed json (only if loaded)
+   nlohmann::json* parsed{ nullptr };
+};
+
+// flat open-addressing hash index of top-level keys (keys are stored contiguously in an arena)
+class FlatIndex final
+{
+private:
+   // all keys, contiguously
+   std::string arena;
+   // entries (in insertion order)
+   std::vector<IndexEntry> entries;
+   // linear probing table of entry positions plus one (zero means empty slot)
+   std::vector<std::uint32_t> slots;
+
+   std::string_view keyOf(const IndexEntry& e) const
+   {
+      return std::string_view(arena.data() + e.key_offset, e.key_length);
+   }
+
+   void rehash(std::size_t nslots)
+   {
+      slots.assign(nslots, 0);
+      for (std::size_t i = 0; i < entries.size(); i++) {
+         std::size_t s = entries[i].hash & (nslots - 1);
+         while (slots[s] != 0)
+            s = (s + 1) & (nslots - 1);
+         slots[s] = std::uint32_t(i + 1);
+      }
+   }
+
+public:
+   std::size_t size() const
+   {
+      return entries.size();
+   }
+
+   void clear()
+   {
+      std::string().swap(arena);
+      std::vector<IndexEntry>().swap(entries);
+      std::vector<std::uint32_t>().swap(slots);
+   }
+
+   // finds key (heterogeneous lookup: no string is built), or null
+   IndexEntry* find(std::string_view key)
+   {
+      if (slots.empty())
+         return nullptr;
+      std::size_t h = std::hash<std::string_view>{}(key);
+      for (std::size_t s = h & (slots.size() - 1); slots[s] != 0; s = (s + 1) & (slots.size() - 1)) {
+         IndexEntry& e = entries[slots[s] - 1];
+         if ((e.hash == h) && (keyOf(e) == key))
+            return &e;
+      }
+      return nullptr;
+   }
+
+   // finds key, or inserts a new (empty) entry for it
+   IndexEntry& insert(std::string_view key)
+   {
+      IndexEntry* found = find(key);
+      if (found)
+         return *found;
+      // keep load factor under 1/2
+      if (2 * (entries.size() + 1) > slots.size())
+         rehash(std::max<std::size_t>(16, 2 * slots.size()));
+      IndexEntry e;
+      e.key_offset = arena.size();
+      e.key_length = key.length();
+      e.hash = std::hash<std::string_view>{}(key);
+      arena.append(key.data(), key.length());
+      entries.push_back(e);
+      std::size_t s = e.hash & (slots.size() - 1);
+      while (slots[s] != 0)
+         s = (s + 1) & (slots.size() - 1);
+      slots[s] = std::uint32_t(entries.size());
+      return entries.back();
+   }
+
+   // heap bytes of index
+   std::size_t footprint() const
+   {
+      return stringHeap(arena) + entries.capacity() * sizeof(IndexEntry) + slots.capacity() * sizeof(std::uint32_t);
+   }
+};
+
+//
+class VastJSON final
+{
+private:
+   static constexpr const char* INDEX_MAGIC = "VJIDX001";
+   ModeVastJSON mode;
+   CacheVastJSON cacheMode{ CACHE_STRING };
+   // multiple json
+   std::map<std::string, nlohmann::json, std::less<>> jsons;
+   // read string cache (in position order for list modes, so iteration follows list)
+   std::map<std::string, std::string, KeyOrder> cache{ KeyOrder{ (mode == BIG_ROOT_LIST) || (mode == BIG_JSON_LINES) } };
+   // byte offsets of top-level entries (only for CACHE_OFFSET)
+   std::map<std::string, ByteRange, std::less<>> offsets;
+   // compressed string cache (only after 'enableCacheCompression()'), where string cache is empty
+   std::map<std::string, std::string, std::less<>> packed;
+   std::unique_ptr<CacheCodec> codec;
+   // pending reads
+   std::unique_ptr<std::istream> ifsptr;
+   // block reader over ifsptr (kept between calls, since it reads ahead)
+   std::unique_ptr<BlockReader> reader;
+   // consumed stream, kept for re-reading offsets (only for CACHE_OFFSET)
+   std::unique_ptr<std::istream> srcptr;
+   // mapped file (offsets are zero-copy slices of it)
+   std::unique_ptr<MappedFile> mapped;
+   // next position to be indexed on mapped file
+   std::size_t mapped_pos = 0;
+   // structural scan over mapped file
+   RootScanState mscan;
+   // count delimiters {} for ifsptr
+   // this variable was local, now it's global since stream consumption can be continued over ifsptr
+   int count_par_ifsptr = 0;
+   // next list position to be indexed (only for BIG_ROOT_LIST and BIG_JSON_LINES)
+   std::size_t next_index = 0;
+   // target element path and siblings (only for BIG_TARGET_ELEMENT)
+   TargetState target;
+   // optional flat hash index over tiers above (see 'enableFlatIndex()')
+   std::unique_ptr<FlatIndex> findex;
+   // parsed entries in recency order (only when memory budget is set)
+   LruState lru;
+   // open containers of value being skipped (scratch, reused by 'skipJSONElement()')
+   std::string skip_stack;
+   // raw bytes read from stream or serialized (scratch, returned by 'getRaw()')
+   std::string raw_buffer;
+   // background indexer (only after 'startPrefetch()')
+   std::unique_ptr<PrefetchState> prefetch;
+   // per-key parse slots (only after 'enableConcurrentReads()')
+   std::unique_ptr<ConcurrentState> concurrent;
+   // segment file of spilled string cache entries (only after 'setSpillThreshold()')
+   std::unique_ptr<SpillState> spill;
+   // bytes of string cache in memory (plain or compressed)
+   std::atomic<std::size_t> cache_bytes{ 0 };
+   // work counters (only after 'enableStats()')
+   std::unique_ptr<StatsState> stats;
+
+public:
+   void clear()
+   {
+      stopPrefetch();
+      concurrent = nullptr;
+      jsons.clear();
+      cache.clear();
+      offsets.clear();
+      packed.clear();
+      cache_bytes = 0;
+      if (spill)
+         spill->clear();
+      reader = nullptr;
+      ifsptr = nullptr;
+      srcptr = nullptr;
+      mapped = nullptr;
+      mapped_pos = 0;
+      mscan = RootScanState();
+      count_par_ifsptr = 0;
+      next_index = 0;
+      target = TargetState();
+      if (findex)
+         findex->clear();
+      lru.clear();
+   }
+
+   std::istream& getIfsptr()
+   {
+      return *ifsptr;
+   }
+
+   int& getCountParIfsptr()
+   {
+      return this->count_par_ifsptr;
+   }
+
+   // storing error flag here
+   bool hasError = false;
+   //
+   ModeVastJSON getMode()
+   {
+      return mode;
+   }
+
+   CacheVastJSON getCacheMode()
+   {
+      return cacheMode;
+   }
+
+   // json outside target element, where target itself is null (for BIG_TARGET_ELEMENT)
+   // note that siblings after target are only known once target is fully indexed (such as after 'size()')
+   const nlohmann::json& getOuter() const
+   {
+      auto lock = guard();
+      return target.outer;
+   }
+
+   const auto begin() const
+   {
+      // force compute cache
+      size();
+      // cache is now complete
+      return cache.begin();
+   }
+
+   const auto end() const
+   {
+      return cache.end();
+   }
+
+   // while background indexer is alive, iterate cache only after 'size()' (or 'stopPrefetch()')
+   const auto beginCache() const
+   {
+      auto lock = guard();
+      // cache may not be complete
+      return cache.begin();
+   }
+
+   const auto endCache() const
+   {
+      return cache.end();
+   }
+
+   bool isPending() const
+   {
+      auto lock = guard();
+      return (ifsptr != nullptr) || (mapped && (mapped_pos < mapped->size()));
+   }
+
+   // cached items size. Note that: cacheSize() <= size()
+   unsigned cacheSize() const
+   {
+      auto lock = guard();
+      return this->cache.size();
+   }
+
+   // return number of top-level entries (not REALLY const...)
+   unsigned size() const
+   {
+      auto lock = guard();
+      if (isPending()) {
+         // sorry, this is quite fake, but necessary!
+         // I know what I'm doing!
+         VastJSON* me = const_cast<VastJSON*>(this);
+         //
+         // must cache all available entries (to calculate 'size()')
+         me->cachePending();
+         // stream has been consumed, drop its memory pointer
+         if (me->ifsptr)
+            me->dropStream();
+      }
+
+      return this->cache.size();
+   }
+
+   // public method: advance on stream until 'targetKey' key is found, or 'count_keys' keys are found
+   void getUntil(std::string targetKey = "", int count_keys = -1)
+   {
+      auto lock = guard();
+      cachePending(targetKey, count_keys);
+   }
+
+   // index all top-level entries of mapped file, splitting it in chunks of 'chunk_size' bytes over 'nthreads' (0 means hardware concurrency)
+   // (streams and partially indexed files are indexed sequentially)
+   void indexParallel(unsigned nthreads = 0, std::size_t chunk_size = 1 << 24)
+   {
+      stopPrefetch(); // whole file is indexed here
+      if (mapped && !mscan.started && (mode == BIG_JSON_LINES))
+         measureScan([this]() { return mapped_pos; }, [&]() { cacheMappedLinesParallel(nthreads, std::max<std::size_t>(1, chunk_size)); });
+      else if (mapped && !mscan.started && (mode != BIG_STRICT))
+         measureScan([this]() { return mapped_pos; }, [&]() { cacheMappedParallel(nthreads, std::max<std::size_t>(1, chunk_size)); });
+      cachePending();
+   }
+
+   // ======================
+   //   sidecar index file
+   // ======================
+
+   // write top-level index of mapped file (keys and byte ranges) into sidecar file (default: '<file>.vjidx')
+   // returns false if there is no mapped file, or some entry has no byte range (such as root primitives)
+   bool saveIndex(std::string path = "")
+   {
+      auto lock = guard();
+      if (!mapped || !mapped->isOpen())
+         return false;
+      size(); // index is complete
+      for (auto& kv : cache)
+         if (offsets.find(kv.first) == offsets.end())
+            return false;
+      if (path == "")
+         path = mapped->getPath() + ".vjidx";
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      if (!ofs)
+         return false;
+      auto put = [&ofs](std::uint64_t v) {
+         ofs.write(reinterpret_cast<const char*>(&v), sizeof(v));
+      };
+      ofs.write(INDEX_MAGIC, 8);
+      put(mapped->size());
+      put(std::uint64_t(mapped->getMTime()));
+      put(mapped->sampleHash());
+      put(cache.size());
+      for (auto& kv : offsets) {
+         put(kv.first.length());
+         ofs.write(kv.first.data(), kv.first.length());
+         put(kv.second.begin);
+         put(kv.second.length());
+      }
+      return bool(ofs);
+   }
+
+   // load top-level index of mapped file from sidecar file (default: '<file>.vjidx'), with no scan of json
+   // returns false (and nothing is changed) if sidecar is missing, corrupted, or does not match mapped file (size, mtime and hash)
+   bool loadIndex(std::string path = "")
+   {
+      stopPrefetch(); // scan state is replaced
+      if (!mapped || !mapped->isOpen() || (mode == BIG_STRICT))
+         return false;
+      if (path == "")
+         path = mapped->getPath() + ".vjidx";
+      std::ifstream ifs(path, std::ios::binary);
+      if (!ifs)
+         return false;
+      std::string data(std::istreambuf_iterator<char>(ifs), {});
+      if (data.compare(0, 8, INDEX_MAGIC) != 0)
+         return false;
+      std::size_t p = 8;
+      auto get = [&data, &p](std::uint64_t& v) {
+         if (p + sizeof(v) > data.length())
+            return false;
+         std::copy(data.data() + p, data.data() + p + sizeof(v), reinterpret_cast<char*>(&v));
+         p += sizeof(v);
+         return true;
+      };
+      std::uint64_t fsize, fmtime, fhash, count;
+      if (!get(fsize) || !get(fmtime) || !get(fhash) || !get(count))
+         return false;
+      if ((fsize != mapped->size()) || (std::int64_t(fmtime) != mapped->getMTime()) || (fhash != mapped->sampleHash()))
+         return false;
+      std::map<std::string, ByteRange, std::less<>> loaded;
+      for (std::uint64_t i = 0; i < count; i++) {
+         std::uint64_t klen, begin, length;
+         if (!get(klen) || (p + klen > data.length()))
+            return false;
+         std::string key = data.substr(p, klen);
+         p += klen;
+         if (!get(begin) || !get(length) || (begin + length > fsize))
+            return false;
+         ByteRange range;
+         range.begin = begin;
+         range.end = begin + length;
+         loaded.emplace_hint(loaded.end(), std::move(key), range);
+      }
+      // index is complete: mapped file is not scanned anymore
+      offsets = std::move(loaded);
+      for (auto& kv : offsets)
+         cache.emplace_hint(cache.end(), kv.first, "");
+      // byte ranges of all entries have changed
+      for (auto it = cache.begin(); findex && (it != cache.end()); ++it)
+         indexNode(it);
+      mscan.started = true;
+      mapped_pos = mapped->size();
+      return true;
+   }
+
+   // load sidecar index if valid, otherwise index mapped file and write sidecar (for instant reopen)
+   bool useIndex(std::string path = "")
+   {
+      if (loadIndex(path))
+         return true;
+      return saveIndex(path);
+   }
+
+   // gets key json
+   nlohmann::json& operator[](std::string_view key)
+   {
+      return this->getKey(key);
+   }
+
+   // gets list position json (for BIG_ROOT_LIST and BIG_JSON_LINES)
+   nlohmann::json& operator[](std::size_t index)
+   {
+      return this->getKey(std::to_string(index));
+   }
+
+   // gets list position json (for BIG_ROOT_LIST and BIG_JSON_LINES) (not REALLY const...)
+   const nlohmann::json& operator[](std::size_t index) const
+   {
+      return this->getKey(std::to_string(index));
+   }
+
+   // checks if key exists (advancing on stream until it's found)
+   bool contains(std::string key)
+   {
+      auto lock = guard();
+      if (findex && findex->find(key))
+         return true;
+      if ((cache.find(key) == cache.end()) && isPending())
+         cachePending(key);
+      return cache.find(key) != cache.end();
+   }
+
+   // lazy forward iteration over list positions (for BIG_ROOT_LIST, BIG_JSON_LINES and list targets of BIG_TARGET_ELEMENT)
+   class ListIterator
+   {
+   private:
+      VastJSON* vastj;
+      std::size_t index;
+
+   public:
+      ListIterator(VastJSON* _vastj, std::size_t _index)
+        : vastj{ _vastj }
+        , index{ _index }
+      {
+      }
+
+      std::size_t position() const
+      {
+         return index;
+      }
+
+      nlohmann::json& operator*()
+      {
+         return (*vastj)[index];
+      }
+
+      ListIterator& operator++()
+      {
+         index++;
+         return *this;
+      }
+
+      // comparing to endList() only advances on stream until current position
+      bool operator!=(const ListIterator& other) const
+      {
+         if (other.index == std::numeric_limits<std::size_t>::max())
+            return vastj->contains(std::to_string(index));
+         return index != other.index;
+      }
+   };
+
+   ListIterator beginList()
+   {
+      return ListIterator(this, 0);
+   }
+
+   ListIterator endList()
+   {
+      return ListIterator(this, std::numeric_limits<std::size_t>::max());
+   }
+
+   // gets key json (not REALLY const...)
+   const nlohmann::json& operator[](std::string_view key) const
+   {
+      return this->getKey(key);
+   }
+
+   std::string& atCache(std::string key)
+   {
+      auto lock = guard();
+      return cacheNode(key)->second;
+   }
+
+   // keeps a flat hash index over string cache, offsets and parsed json, so lookups of parsed keys cost a
+   // single hash probe (instead of tree walks), and so do lookups of keys on string cache or byte range
+   // (besides storing parsed json). compressed and spilled entries are still found on their own tiers.
+   void enableFlatIndex()
+   {
+      auto lock = guard();
+      if (findex)
+         return;
+      findex.reset(new FlatIndex());
+      for (auto it = cache.begin(); it != cache.end(); ++it)
+         indexNode(it);
+   }
+
+   bool hasFlatIndex() const
+   {
+      return findex != nullptr;
+   }
+
+   // keeps string cache compressed in memory (entries are decompressed inside 'getKey'), compressing entries already cached.
+   // with 'dict_size' > 0 (and zstd), a shared dictionary is trained from entries already cached (good for many small entries).
+   // compressed entries are empty on 'atCache()' and iteration (use 'getRaw()').
+   // returns false if no codec is built in (define VASTJSON_WITH_ZSTD or VASTJSON_WITH_ZLIB).
+   bool enableCacheCompression(int level = 3, std::size_t dict_size = 0)
+   {
+      if (!CacheCodec::available()) {
+         std::cerr << "WARNING: VastJSON built with no codec for cache compression" << std::endl;
+         return false;
+      }
+      disableConcurrentReads();
+      auto lock = guard();
+      std::vector<std::string_view> samples;
+      for (auto& kv : cache)
+         if (kv.second != "")
+            samples.push_back(kv.second);
+      codec.reset(new CacheCodec(level, samples, dict_size));
+      for (auto& kv : cache) {
+         if (kv.second != "") {
+            std::string raw;
+            raw.swap(kv.second);
+            cache_bytes -= raw.length();
+            storeCache(kv.first, std::move(raw));
+         }
+      }
+      return true;
+   }
+
+   bool hasCacheCompression() const
+   {
+      return codec != nullptr;
+   }
+
+   // bytes of compressed string cache
+   std::size_t packedBytes() const
+   {
+      auto lock = guard();
+      std::size_t n = 0;
+      for (auto& kv : packed)
+         n += kv.second.length();
+      return n;
+   }
+
+   // bounds memory of string cache (in bytes, including compressed entries): entries stored while over
+   // threshold are appended to a temporary segment file (on 'dir', or system temp dir), and read back on access.
+   // this is the way to index huge non-seekable sources (pipes, stdin), where CACHE_OFFSET is not possible.
+   // plain entries already cached are spilled until under threshold. zero stops spilling (spilled entries are kept).
+   // returns false if segment file cannot be created.
+   bool setSpillThreshold(std::size_t bytes, std::string dir = "")
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      if (bytes && !spill) {
+         std::unique_ptr<SpillState> s(new SpillState());
+         if (!s->open(dir)) {
+            std::cerr << "WARNING: VastJSON cannot create spill file" << std::endl;
+            this->hasError = true;
+            return false;
+         }
+         spill = std::move(s);
+      }
+      if (!spill)
+         return true;
+      spill->threshold = bytes;
+      for (auto& kv : cache) {
+         if (!bytes || (cache_bytes <= bytes))
+            break;
+         std::size_t n = kv.second.length();
+         if ((n > 0) && spillEntry(kv.first, kv.second))
+            cache_bytes -= n;
+      }
+      return true;
+   }
+
+   // bytes used on spill segment file (spilled entries and freed extents to be reused)
+   std::size_t spillFileBytes() const
+   {
+      auto lock = guard();
+      return spill ? std::size_t(spill->size) : 0;
+   }
+
+   // bytes of string cache in memory (plain or compressed)
+   std::size_t cacheBytes() const
+   {
+      return cache_bytes;
+   }
+
+   // bytes of entries currently spilled to disk
+   std::size_t spilledBytes() const
+   {
+      auto lock = guard();
+      std::size_t n = 0;
+      if (spill)
+         for (auto& kv : spill->ranges)
+            n += kv.second.length();
+      return n;
+   }
+
+   // bounds memory of parsed json (estimated, in bytes): least recently used entries are
+   // demoted back to their offset form (or string cache, as 'toCache()') when over budget.
+   // the most recently accessed entry is always kept, and zero disables the budget.
+   // note that references from 'getKey()' may be invalidated by later accesses.
+   void setMemoryBudget(std::size_t bytes)
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      if (bytes && !tracking())
+         trackParsed();
+      lru.budget = bytes;
+      if (!tracking())
+         lru.clear();
+      evictParsed();
+   }
+
+   std::size_t getMemoryBudget() const
+   {
+      return concurrent ? concurrent->budget : lru.budget;
+   }
+
+   // estimated bytes of parsed json (zero unless memory budget or stats are enabled)
+   std::size_t parsedBytes() const
+   {
+      auto lock = guard();
+      return lru.used;
+   }
+
+   // memory held by top-level entry (all zero if it's not indexed). parsed json is walked, so it's O(size of entry).
+   // entries parsed on concurrent read mode are not accounted (until it's disabled).
+   MemoryVastJSON memoryUsage(std::string_view key) const
+   {
+      auto lock = guard();
+      MemoryVastJSON m;
+      auto it = cache.find(key);
+      if (it != cache.end())
+         accountEntry(it->first, it->second, m);
+      return m;
+   }
+
+   // memory held by all tiers (parsed json is walked, so it's O(size of parsed json))
+   MemoryVastJSON memoryUsage() const
+   {
+      auto lock = guard();
+      MemoryVastJSON m;
+      for (auto& kv : cache)
+         accountEntry(kv.first, kv.second, m);
+      for (auto& kv : lru.where)
+         m.other += (2 * sizeof(void*) + sizeof(std::string)) + (MAP_NODE + sizeof(kv)) + 2 * stringHeap(kv.first); // list and map nodes
+      if (findex)
+         m.other += findex->footprint();
+      if (reader)
+         m.other += reader->footprint();
+      m.other += stringHeap(skip_stack) + stringHeap(raw_buffer);
+      return m;
+   }
+
+   // calls 'fn(key, memory)' for each top-level entry indexed so far (in key order)
+   void memoryUsage(std::function<void(const std::string&, const MemoryVastJSON&)> fn) const
+   {
+      auto lock = guard();
+      for (auto& kv : cache) {
+         MemoryVastJSON m;
+         accountEntry(kv.first, kv.second, m);
+         fn(kv.first, m);
+      }
+   }
+
+   // starts counting work done from now on: bytes scanned, entries indexed, parses, hits and misses,
+   // evictions and time per phase, besides peak bytes of string cache and parsed json (which is tracked, as
+   // for memory budget). counters have a small cost (a clock read per parse), so only enable them when measuring.
+   void enableStats()
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      if (stats)
+         return;
+      if (!tracking())
+         trackParsed();
+      stats.reset(new StatsState());
+      stats->peak_cache_bytes = cache_bytes.load();
+      stats->peak_json_bytes = lru.used;
+   }
+
+   void disableStats()
+   {
+      auto lock = guard();
+      stats = nullptr;
+      if (!tracking())
+         lru.clear();
+   }
+
+   bool hasStats() const
+   {
+      return stats != nullptr;
+   }
+
+   // zero all counters (peaks restart from current sizes)
+   void resetStats()
+   {
+      auto lock = guard();
+      if (stats) {
+         stats.reset(new StatsState());
+         stats->peak_cache_bytes = cache_bytes.load();
+         stats->peak_json_bytes = lru.used;
+      }
+   }
+
+   // snapshot of counters (all zero if stats are not enabled)
+   StatsVastJSON getStats() const
+   {
+      auto lock = guard();
+      StatsVastJSON out;
+      if (!stats)
+         return out;
+      out.bytes_scanned = stats->bytes_scanned;
+      out.entries_indexed = stats->entries_indexed;
+      out.parse_calls = stats->parse_calls;
+      out.parse_bytes = stats->parse_bytes;
+      out.cache_hits = stats->cache_hits;
+      out.cache_misses = stats->cache_misses;
+      out.evictions = stats->evictions;
+      out.serializations = stats->serializations;
+      out.scan_ns = stats->scan_ns;
+      out.parse_ns = stats->parse_ns;
+      out.serialize_ns = stats->serialize_ns;
+      out.cache_bytes = cache_bytes;
+      out.peak_cache_bytes = stats->peak_cache_bytes;
+      out.json_bytes = lru.used;
+      out.peak_json_bytes = stats->peak_json_bytes;
+      return out;
+   }
+
+   // ======================
+   //   background indexing
+   // ======================
+
+   // keeps indexing pending source on a background thread, publishing 'batch_keys' keys at a time,
+   // while already indexed keys are served (lookups of missing keys still advance on source inline).
+   // while worker is alive, all public accesses are serialized by a mutex (link with '-pthread'),
+   // and 'indexParallel()' or 'loadIndex()' stop it first.
+   void startPrefetch(int batch_keys = 64)
+   {
+      disableConcurrentReads();
+      if (prefetch || !isPending() || (mode == BIG_STRICT))
+         return;
+      prefetch.reset(new PrefetchState());
+      batch_keys = std::max(1, batch_keys);
+      prefetch->worker = std::thread([this, batch_keys]() {
+         PrefetchState& pf = *prefetch;
+         while (!pf.stop) {
+            std::lock_guard<std::recursive_mutex> lock(pf.mtx);
+            if (!isPending())
+               break;
+            cachePending("", batch_keys);
+            pf.published.notify_all();
+         }
+         std::lock_guard<std::recursive_mutex> lock(pf.mtx);
+         pf.done = true;
+         pf.published.notify_all();
+      });
+   }
+
+   // stops background indexer (remaining source is indexed on demand, as usual)
+   void stopPrefetch()
+   {
+      if (!prefetch)
+         return;
+      prefetch->stop = true;
+      prefetch->worker.join();
+      prefetch = nullptr;
+   }
+
+   bool isPrefetching() const
+   {
+      return prefetch != nullptr;
+   }
+
+   // waits until 'key' is indexed by background indexer (or source is finished), returning true if it exists
+   // (with no background indexer, this is the same as 'contains(key)')
+   bool waitKey(std::string key)
+   {
+      if (!prefetch)
+         return contains(key);
+      std::unique_lock<std::recursive_mutex> lock(prefetch->mtx);
+      prefetch->published.wait(lock, [this, &key]() {
+         return prefetch->done || (cache.find(key) != cache.end());
+      });
+      return cache.find(key) != cache.end();
+   }
+
+   // ======================
+   //   concurrent reads
+   // ======================
+
+   // allows many threads to read a shared VastJSON: source is fully indexed (so index is never changed again),
+   // and each entry is parsed exactly once (by first thread asking for it) into its own slot, with no global lock.
+   // in this mode, 'getKey', 'operator[]', 'contains' and 'size' are thread-safe
+   // (a missing key throws std::out_of_range, instead of being created). memory budget is suspended until it's left.
+   // all other methods (such as 'unload', 'toCache' or 'getRaw') are not thread-safe, and mutating ones
+   // leave concurrent mode (see 'disableConcurrentReads()').
+   void enableConcurrentReads()
+   {
+      if (concurrent)
+         return;
+      stopPrefetch();
+      size(); // index is complete
+      concurrent.reset(new ConcurrentState());
+      concurrent->budget = lru.budget;
+      lru.budget = 0;
+      for (auto& kv : cache) {
+         auto slot = concurrent->slots.emplace_hint(concurrent->slots.end(), std::piecewise_construct, std::forward_as_tuple(kv.first), std::forward_as_tuple());
+         auto it = jsons.find(kv.first);
+         if (it != jsons.end())
+            std::call_once(slot->second.once, [&]() { slot->second.parsed = &it->second; });
+      }
+   }
+
+   // leave concurrent mode (must not race with readers): entries parsed meanwhile are kept as parsed json
+   // (and accounted on memory budget, which is enforced again)
+   void disableConcurrentReads()
+   {
+      if (!concurrent)
+         return;
+      lru.budget = concurrent->budget;
+      std::unique_ptr<ConcurrentState> state = std::move(concurrent);
+      for (auto& kv : state->slots) {
+         if (kv.second.parsed == &kv.second.value) {
+            dropStored(kv.first);
+            nlohmann::json& j = storeJSON(kv.first, std::move(kv.second.value));
+            if (tracking())
+               touchParsed(kv.first, &j);
+         }
+      }
+      evictParsed();
+   }
+
+   bool isConcurrent() const
+   {
+      return concurrent != nullptr;
+   }
+
+   // get key in json structured format (not REALLY const...)
+   const nlohmann::json& getKey(std::string_view key) const
+   {
+      // sorry, this is quite fake, but necessary!
+      // I know what I'm doing!
+      VastJSON* me = const_cast<VastJSON*>(this);
+      return me->getKey(key);
+   }
+
+   // get key in json structured format
+   nlohmann::json& getKey(std::string_view key)
+   {
+      if (concurrent)
+         return concurrentKey(key);
+      auto lock = guard();
+      // with flat index, parsed state is known from a single probe (no walk on 'jsons')
+      IndexEntry* e = findex ? findex->find(key) : nullptr;
+      auto it = (findex && !(e && e->parsed)) ? jsons.end() : jsons.find(key);
+      if (e && e->parsed) {
+         countAccess(true);
+         if (tracking())
+            touchParsed(key, nullptr);
+         return *e->parsed;
+      }
+      if (it != jsons.end()) {
+         countAccess(true);
+         if (tracking())
+            touchParsed(key, nullptr);
+         return it->second;
+      }
+      countAccess(false);
+      if (e && (*e->cached != "")) {
+         // string cache is served from index
+         nlohmann::json parsed = parseEntry(*e->cached);
+         dropCached(*e->cached); // release string memory
+         std::string skey(key);
+         return budgeted(skey, storeJSON(skey, std::move(parsed)));
+      }
+      if (e && e->range && packed.empty() && !(spill && spill->ranges.count(key))) {
+         // byte range is served from index (when there's no newer compressed or spilled copy)
+         std::string skey(key);
+         return budgeted(skey, storeJSON(skey, parseRange(*e->range)));
+      }
+      auto it2 = cache.find(key);
+      if ((it2 == cache.end()) && isPending()) {
+         // CHECK IF THERE'S MORE TO READ IN 'ifsptr' (or mapped file)
+         cachePending(std::string(key));
+         // root primitives are parsed directly
+         it = jsons.find(key);
+         if (it != jsons.end())
+            return budgeted(it->first, it->second);
+         // try again and update iterator
+         it2 = cache.find(key);
+      }
+      if (it2 == cache.end()) {
+         // NOTHING ELSE TO DO... KEY DOES NOT EXIST!
+         //std::cerr << "BigJSON::getKey() error: key '" << key << "' does not exist!" << std::endl;
+         it2 = cacheNode(key);
+      }
+      std::string& cached = it2->second;
+      auto itp = packed.find(key);
+      if ((cached == "") && (itp != packed.end())) {
+         nlohmann::json parsed = parseEntry(codec->decompress(itp->second));
+         dropStored(key);
+         return budgeted(it2->first, storeJSON(it2->first, std::move(parsed)));
+      }
+      std::string spilled;
+      if ((cached == "") && readSpilled(key, spilled)) {
+         nlohmann::json parsed = parseEntry(spilled);
+         dropStored(key);
+         return budgeted(it2->first, storeJSON(it2->first, std::move(parsed)));
+      }
+      if (cached == "") {
+         // offset-indexed entries are re-read from source stream (or mapped file)
+         auto it3 = offsets.find(key);
+         if (it3 != offsets.end())
+            return budgeted(it2->first, storeJSON(it2->first, parseRange(it3->second)));
+         //std::cerr << "BigJSON::getKey() error: key '" << key << "' is empty or has been unloaded!" << std::endl;
+      }
+
+      // TODO: continue even with error (or return 'optional' for recovery?)
+      assert(cached.length() > 0);
+      nlohmann::json parsed = parseEntry(cached);
+      dropCached(cached); // release string memory
+      return budgeted(it2->first, storeJSON(it2->first, std::move(parsed)));
+   }
+
+   // gets exact original bytes of top-level value, with no parsing (empty if key does not exist).
+   // view points into string cache or mapped file (zero-copy), and is valid until entry is changed;
+   // for streams (CACHE_OFFSET) or already parsed entries, bytes are read (or dumped) into an
+   // internal buffer, valid until next 'getRaw()'.
+   std::string_view getRaw(std::string_view key)
+   {
+      auto lock = guard();
+      auto it = cache.find(key);
+      if ((it == cache.end()) && isPending()) {
+         cachePending(std::string(key));
+         it = cache.find(key);
+      }
+      if (it == cache.end())
+         return std::string_view();
+      if (it->second != "")
+         return it->second;
+      auto itp = packed.find(key);
+      if (itp != packed.end()) {
+         raw_buffer = codec->decompress(itp->second);
+         return raw_buffer;
+      }
+      if (readSpilled(key, raw_buffer))
+         return raw_buffer;
+      auto it2 = offsets.find(key);
+      if (it2 != offsets.end()) {
+         if (mapped)
+            return std::string_view(mapped->data() + it2->second.begin, it2->second.length());
+         raw_buffer = readRange(it2->second);
+         return raw_buffer;
+      }
+      auto it3 = jsons.find(key);
+      if (it3 == jsons.end())
+         return std::string_view(); // unloaded
+      raw_buffer = it3->second.dump();
+      return raw_buffer;
+   }
+
+   // parses entries of 'keys' over 'nthreads' worker threads (0 means hardware concurrency), storing them as parsed json.
+   // returns pointers to parsed entries, in order of 'keys' (null for missing keys, or bad entries, which set 'hasError').
+   // source is read sequentially, and only 'nlohmann::json::parse' runs in parallel.
+   // memory budget is only enforced on next access, so pointers are valid until then.
+   std::vector<nlohmann::json*> getKeys(const std::vector<std::string>& keys, unsigned nthreads = 0)
+   {
+      std::vector<nlohmann::json*> out(keys.size(), nullptr);
+      if (concurrent) {
+         // bad entries throw on their worker (slot is left unparsed, so later accesses throw as usual)
+         std::vector<char> failed(keys.size(), 0);
+         parallelFor(keys.size(), nthreads, [&](std::size_t i) {
+            try {
+               if (concurrent->slots.count(keys[i]))
+                  out[i] = &concurrentKey(keys[i]);
+            } catch (const std::exception&) {
+               failed[i] = 1;
+            }
+         });
+         for (std::size_t i = 0; i < keys.size(); i++) {
+            if (failed[i]) {
+               std::cerr << "WARNING: VastJSON failed to parse key '" << keys[i] << "'" << std::endl;
+               this->hasError = true;
+            }
+         }
+         return out;
+      }
+      auto lock = guard();
+      // raw text of entries to be parsed (views on string cache or mapped file, or read from stream)
+      std::vector<const std::string*> todo;
+      std::vector<std::string_view> raws;
+      std::vector<std::string> owned;
+      owned.reserve(keys.size()); // views on 'owned' must not be invalidated
+      std::set<std::string_view> seen;
+      for (auto& key : keys) {
+         if (jsons.count(key)) {
+            countAccess(true);
+            continue;
+         }
+         countAccess(false);
+         auto it = cache.find(key);
+         if ((it == cache.end()) && isPending()) {
+            cachePending(key);
+            it = cache.find(key);
+         }
+         if ((it == cache.end()) || jsons.count(key) || !seen.insert(it->first).second)
+            continue;
+         auto it2 = offsets.find(key);
+         auto itp = packed.find(key);
+         std::string spilled;
+         if (it->second != "")
+            raws.push_back(it->second);
+         else if (itp != packed.end()) {
+            owned.push_back(codec->decompress(itp->second));
+            raws.push_back(owned.back());
+         } else if (readSpilled(key, spilled)) {
+            owned.push_back(std::move(spilled));
+            raws.push_back(owned.back());
+         } else if ((it2 != offsets.end()) && mapped)
+            raws.emplace_back(mapped->data() + it2->second.begin, it2->second.length());
+         else if (it2 != offsets.end()) {
+            owned.push_back(readRange(it2->second));
+            raws.push_back(owned.back());
+         } else
+            continue; // unloaded
+         todo.push_back(&it->first);
+      }
+      // parse in parallel (with no exceptions on worker threads)
+      std::vector<nlohmann::json> parsed(todo.size());
+      parallelFor(todo.size(), nthreads, [&](std::size_t i) {
+         parsed[i] = parseEntry(raws[i], false);
+      });
+      std::vector<std::string>().swap(owned);
+      for (std::size_t i = 0; i < todo.size(); i++) {
+         const std::string& key = *todo[i];
+         if (parsed[i].is_discarded()) {
+            std::cerr << "WARNING: VastJSON failed to parse key '" << key << "'" << std::endl;
+            this->hasError = true;
+            continue;
+         }
+         dropCached(cache.find(key)->second); // release string memory
+         dropStored(key);
+         nlohmann::json& j = storeJSON(key, std::move(parsed[i]));
+         if (tracking())
+            touchParsed(key, &j);
+      }
+      for (std::size_t i = 0; i < keys.size(); i++) {
+         auto it = jsons.find(keys[i]);
+         if (it != jsons.end())
+            out[i] = &it->second;
+      }
+      return out;
+   }
+
+   // parses all top-level entries with key matching 'pred' over 'nthreads' worker threads (as above),
+   // then calls 'fn(key, json)' on each of them (in key order)
+   void getKeys(std::function<bool(const std::string&)> pred, std::function<void(const std::string&, nlohmann::json&)> fn, unsigned nthreads = 0)
+   {
+      auto lock = guard();
+      size(); // index is complete
+      std::vector<std::string> keys;
+      for (auto& kv : cache)
+         if (pred(kv.first))
+            keys.push_back(kv.first);
+      std::vector<nlohmann::json*> out = getKeys(keys, nthreads);
+      for (std::size_t i = 0; i < keys.size(); i++)
+         if (out[i])
+            fn(keys[i], *out[i]);
+   }
+
+   // eager load: whole source is indexed, then all entries are parsed over 'nthreads' worker threads
+   // (0 means hardware concurrency), straight into their json slots. string cache of each entry is dropped
+   // as soon as it's parsed, so peak memory is about one copy of source plus parsed json.
+   // entries that fail to parse are kept as they were (setting 'hasError').
+   void loadAll(unsigned nthreads = 0)
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      size(); // index is complete
+      // cache nodes to be parsed, and their (empty) json slots
+      std::vector<std::map<std::string, std::string, KeyOrder>::iterator> todo;
+      std::vector<nlohmann::json*> slots;
+      for (auto it = cache.begin(); it != cache.end(); ++it) {
+         if (jsons.count(it->first) || ((it->second == "") && !offsets.count(it->first) && !packed.count(it->first) && !(spill && spill->ranges.count(it->first))))
+            continue; // already parsed (or unloaded)
+         todo.push_back(it);
+         slots.push_back(&storeJSON(it->first, nlohmann::json()));
+      }
+      // each worker only touches cache node and slot of its entry (no exceptions on worker threads)
+      std::mutex stream_mtx;
+      parallelFor(todo.size(), nthreads, [&](std::size_t i) {
+         std::string& cached = todo[i]->second;
+         if (cached != "") {
+            *slots[i] = parseEntry(cached, false);
+            if (!slots[i]->is_discarded())
+               dropCached(cached); // release string memory
+            return;
+         }
+         auto itp = packed.find(todo[i]->first);
+         if (itp != packed.end()) {
+            *slots[i] = parseEntry(codec->decompress(itp->second), false);
+            return;
+         }
+         std::string spilled;
+         if (readSpilled(todo[i]->first, spilled)) {
+            *slots[i] = parseEntry(spilled, false);
+            return;
+         }
+         const ByteRange& range = offsets.find(todo[i]->first)->second;
+         if (mapped) {
+            const char* first = mapped->data() + range.begin;
+            *slots[i] = parseEntry(std::string_view(first, range.length()), false);
+            return;
+         }
+         std::string raw;
+         {
+            std::lock_guard<std::mutex> slock(stream_mtx);
+            raw = readRange(range);
+         }
+         *slots[i] = parseEntry(raw, false);
+      });
+      for (std::size_t i = 0; i < todo.size(); i++) {
+         const std::string& key = todo[i]->first;
+         if (slots[i]->is_discarded()) {
+            std::cerr << "WARNING: VastJSON failed to parse key '" << key << "'" << std::endl;
+            this->hasError = true;
+            if (findex)
+               findex->insert(key).parsed = nullptr;
+            jsons.erase(key);
+            continue;
+         }
+         dropStored(key);
+         if (tracking())
+            touchParsed(key, slots[i]);
+      }
+      evictParsed();
+   }
+
+   // unload json structure and do not keep string cache
+   void unload(std::string key)
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      dropCached(cacheNode(key)->second); // mark as empty
+      dropStored(key);
+      auto it = jsons.find(key);
+      if (it == jsons.end()) {
+         //std::cerr << "BigJSON::unload() error: json key '" << key << "' does not exist!" << std::endl;
+         return;
+      }
+      if (findex)
+         findex->insert(key).parsed = nullptr;
+      if (tracking())
+         forgetParsed(key);
+      jsons.erase(it); // drop json structure
+   }
+
+   // move json structure back to string cache (since json structured format may be more memory costly)
+   void toCache(std::string key)
+   {
+      disableConcurrentReads();
+      auto lock = guard();
+      auto it = jsons.find(key);
+      if (it == jsons.end()) {
+         //std::cerr << "BigJSON::toCache() error: json key '" << key << "' does not exist!" << std::endl;
+         return;
+      }
+      //
+      std::string str;
+      {
+         StatsTimer timer(stats ? &stats->serialize_ns : nullptr);
+         str = it->second.dump();
+      }
+      if (stats)
+         stats->serializations++;
+      unload(key);                     // unload json structure
+      storeCache(key, std::move(str)); // keep string in cache (compressed, if enabled)
+   }
+
+   // ======================
+   //     constructors
+   // ======================
+
+private:
+   // lock over all tiers, only while background indexer is alive (otherwise, not locked)
+   std::unique_lock<std::recursive_mutex> guard() const
+   {
+      if (!prefetch)
+         return std::unique_lock<std::recursive_mutex>();
+      return std::unique_lock<std::recursive_mutex>(prefetch->mtx);
+   }
+
+   // get key on concurrent mode (parsed once on its slot, with no lock over other keys)
+   nlohmann::json& concurrentKey(std::string_view key)
+   {
+      auto it = concurrent->slots.find(key);
+      if (it == concurrent->slots.end())
+         throw std::out_of_range("VastJSON: key '" + std::string(key) + "' does not exist");
+      ConcurrentSlot& slot = it->second;
+      bool hit = true;
+      std::call_once(slot.once, [&]() {
+         hit = false;
+         // only this thread touches cache node (and byte range) of key
+         std::string& cached = cache.find(key)->second;
+         auto it2 = offsets.find(key);
+         auto itp = packed.find(key);
+         std::string spilled;
+         if (cached != "") {
+            slot.value = parseEntry(cached);
+            dropCached(cached); // release string memory
+         } else if (itp != packed.end()) {
+            slot.value = parseEntry(codec->decompress(itp->second));
+         } else if (readSpilled(key, spilled)) {
+            slot.value = parseEntry(spilled);
+         } else if ((it2 != offsets.end()) && mapped) {
+            slot.value = parseRange(it2->second);
+         } else if (it2 != offsets.end()) {
+            std::string raw;
+            {
+               std::lock_guard<std::mutex> lock(concurrent->stream_mtx);
+               raw = readRange(it2->second);
+            }
+            slot.value = parseEntry(raw);
+         } else
+            throw std::out_of_range("VastJSON: key '" + std::string(key) + "' has been unloaded");
+         slot.parsed = &slot.value;
+      });
+      countAccess(hit);
+      return *slot.parsed;
+   }
+
+   // advance on pending source until 'targetKey' is found, or 'count_keys' keys are found
+   void cachePending(std::string targetKey = "", int count_keys = -1)
+   {
+      if (ifsptr) {
+         cacheUntil(*ifsptr, count_par_ifsptr, targetKey, count_keys);
+         // IF stream has been consumed, drop its memory pointer
+         if (reader && reader->eof())
+            dropStream();
+      } else if (mapped && (mapped_pos < mapped->size())) {
+         measureScan([this]() { return mapped_pos; }, [&]() {
+            if (mode == BIG_JSON_LINES)
+               cacheUntilMappedLines(targetKey, count_keys);
+            else
+               cacheUntilMapped(targetKey, count_keys);
+         });
+      }
+   }
+
+   // ======================
+   //   tiers maintenance
+   // ======================
+
+   // register cache node on flat index (if enabled)
+   void indexNode(std::map<std::string, std::string, KeyOrder>::iterator node)
+   {
+      if (!findex)
+         return;
+      IndexEntry& e = findex->insert(node->first);
+      e.cached = &node->second;
+      auto it = offsets.find(node->first);
+      e.range = (it != offsets.end()) ? &it->second : nullptr;
+      auto it2 = jsons.find(node->first);
+      e.parsed = (it2 != jsons.end()) ? &it2->second : nullptr;
+   }
+
+   // cache node of key (created empty if missing)
+   std::map<std::string, std::string, KeyOrder>::iterator cacheNode(std::string_view key)
+   {
+      auto it = cache.find(key);
+      if (it == cache.end()) {
+         it = cache.emplace(std::string(key), "").first;
+         indexNode(it);
+      }
+      return it;
+   }
+
+   // store top-level entry as string (compressed, if enabled), or on spill file when over threshold
+   void storeCache(const std::string& key, std::string&& raw)
+   {
+      auto it = cacheNode(key);
+      dropCached(it->second);
+      dropStored(key);
+      std::string compressed = codec ? codec->compress(raw) : std::string();
+      std::size_t bytes = codec ? compressed.length() : raw.length();
+      if (spill && spill->threshold && (cache_bytes + bytes > spill->threshold) && spillEntry(key, raw))
+         return;
+      cache_bytes += bytes;
+      if (stats)
+         StatsState::raise(stats->peak_cache_bytes, cache_bytes);
+      if (codec) {
+         packed[key] = std::move(compressed);
+         std::string().swap(raw);
+      } else
+         it->second = std::move(raw);
+   }
+
+   // append raw entry to spill file (releasing 'raw'); false keeps entry in memory
+   bool spillEntry(const std::string& key, std::string& raw)
+   {
+      ByteRange range;
+      if (!spill->append(raw, range)) {
+         std::cerr << "WARNING: VastJSON failed to write spill file" << std::endl;
+         this->hasError = true;
+         return false;
+      }
+      spill->ranges[key] = range;
+      std::string().swap(raw);
+      return true;
+   }
+
+   // read spilled entry of key into 'raw' (false if not spilled)
+   bool readSpilled(std::string_view key, std::string& raw)
+   {
+      if (!spill)
+         return false;
+      auto it = spill->ranges.find(key);
+      if (it == spill->ranges.end())
+         return false;
+      raw = spill->read(it->second);
+      return true;
+   }
+
+   // release string of cache node
+   void dropCached(std::string& cached)
+   {
+      cache_bytes -= cached.length();
+      std::string().swap(cached);
+   }
+
+   // drop compressed and spilled copies of entry
+   void dropStored(std::string_view key)
+   {
+      auto itp = packed.find(key);
+      if (itp != packed.end()) {
+         cache_bytes -= itp->second.length();
+         packed.erase(itp);
+      }
+      if (spill)
+         spill->release(key);
+   }
+
+   // store top-level entry as byte range on source (empty string cache)
+   void storeOffset(const std::string& key, const ByteRange& range)
+   {
+      offsets[key] = range;
+      auto it = cacheNode(key);
+      dropCached(it->second);
+      if (findex)
+         indexNode(it);
+   }
+
+   // store top-level entry as parsed json
+   nlohmann::json& storeJSON(const std::string& key, nlohmann::json&& parsed)
+   {
+      nlohmann::json& j = jsons[key];
+      j = std::move(parsed);
+      cacheNode(key);
+      if (findex)
+         findex->insert(key).parsed = &j;
+      return j;
+   }
+
+   // ======================
+   //     memory budget
+   // ======================
+
+   // mark parsed key as most recently used (footprint is computed once, when 'j' is given)
+   void touchParsed(std::string_view key, const nlohmann::json* j)
+   {
+      auto it = lru.where.find(key);
+      if (it != lru.where.end()) {
+         lru.order.splice(lru.order.begin(), lru.order, it->second.first);
+         return;
+      }
+      if (!j)
+         j = &jsons.find(key)->second;
+      lru.order.emplace_front(key);
+      std::size_t bytes = jsonFootprint(*j);
+      lru.where.emplace(std::string(key), std::make_pair(lru.order.begin(), bytes));
+      lru.used += bytes;
+      if (stats)
+         StatsState::raise(stats->peak_json_bytes, lru.used);
+   }
+
+   // add memory of entry (on all tiers) to 'm'
+   void accountEntry(const std::string& key, const std::string& cached, MemoryVastJSON& m) const
+   {
+      std::size_t node = MAP_NODE + sizeof(std::string) + stringHeap(key);
+      m.cache += stringHeap(cached);
+      m.keys += node + sizeof(std::string);
+      if (offsets.count(key))
+         m.keys += node + sizeof(ByteRange);
+      auto itp = packed.find(key);
+      if (itp != packed.end()) {
+         m.packed += stringHeap(itp->second);
+         m.keys += node + sizeof(std::string);
+      }
+      auto itj = jsons.find(key);
+      if (itj != jsons.end()) {
+         m.json += jsonFootprint(itj->second);
+         m.keys += node;
+      }
+      if (spill) {
+         auto its = spill->ranges.find(key);
+         if (its != spill->ranges.end()) {
+            m.spilled += its->second.length();
+            m.keys += node + sizeof(ByteRange);
+         }
+      }
+   }
+
+   // parsed entries are tracked (for memory budget or stats)
+   bool tracking() const
+   {
+      return lru.budget || stats;
+   }
+
+   // start tracking entries already parsed
+   void trackParsed()
+   {
+      for (auto& kv : jsons)
+         touchParsed(kv.first, &kv.second);
+   }
+
+   // count access to top-level entry, already parsed (hit) or not (miss)
+   void countAccess(bool hit)
+   {
+      if (stats)
+         (hit ? stats->cache_hits : stats->cache_misses)++;
+   }
+
+   // parse top-level entry (counted on stats, if enabled)
+   nlohmann::json parseEntry(std::string_view raw, bool allow_exceptions = true)
+   {
+      if (!stats)
+         return nlohmann::json::parse(raw.begin(), raw.end(), nullptr, allow_exceptions);
+      StatsTimer timer(&stats->parse_ns);
+      stats->parse_calls++;
+      stats->parse_bytes += raw.length();
+      return nlohmann::json::parse(raw.begin(), raw.end(), nullptr, allow_exceptions);
+   }
+
+   // run indexing step 'scan', counting entries indexed, time, and bytes scanned (as difference of 'position()')
+   template<class Position, class Scan>
+   void measureScan(Position position, Scan scan)
+   {
+      if (!stats) {
+         scan();
+         return;
+      }
+      std::uint64_t first = position();
+      std::size_t entries = cache.size();
+      {
+         StatsTimer timer(&stats->scan_ns);
+         scan();
+      }
+      stats->bytes_scanned += position() - first;
+      stats->entries_indexed += cache.size() - entries;
+   }
+
+   void forgetParsed(std::string_view key)
+   {
+      auto it = lru.where.find(key);
+      if (it == lru.where.end())
+         return;
+      lru.used -= it->second.second;
+      lru.order.erase(it->second.first);
+      lru.where.erase(it);
+   }
+
+   // demote least recently used entries until under budget (keeping the most recent one)
+   void evictParsed()
+   {
+      while (lru.budget && (lru.used > lru.budget) && (lru.order.size() > 1)) {
+         std::string victim = lru.order.back();
+         if (stats)
+            stats->evictions++;
+         if (offsets.count(victim))
+            unload(victim); // re-read from source on demand
+         else
+            toCache(victim);
+      }
+   }
+
+   // account freshly parsed entry on memory budget
+   nlohmann::json& budgeted(const std::string& key, nlohmann::json& j)
+   {
+      if (tracking()) {
+         touchParsed(key, &j);
+         evictParsed();
+      }
+      return j;
+   }
+
+   // stream has been consumed: drop its memory pointer (or keep it for re-reading offsets)
+   void dropStream()
+   {
+      reader = nullptr;
+      if (cacheMode == CACHE_OFFSET)
+         srcptr = std::move(ifsptr);
+      ifsptr = nullptr;
+   }
+
+   // re-read raw entry from source stream (only for CACHE_OFFSET)
+   std::string readRange(const ByteRange& range)
+   {
+      std::istream* src = ifsptr ? ifsptr.get() : srcptr.get();
+      if (!src) {
+         std::cerr << "WARNING: VastJSON CACHE_OFFSET has no stream to re-read." << std::endl;
+         this->hasError = true;
+         return "";
+      }
+      std::string raw(range.length(), '\0');
+      // stream may be in eof state (or pending): keep position for further caching
+      src->clear();
+      std::streampos resume = src->tellg();
+      src->seekg(range.begin);
+      src->read(&raw[0], raw.length());
+      src->clear();
+      src->seekg(resume);
+      return raw;
    }
 
-   std::string& atCache(std::string key)
+   // parse offset-indexed entry (zero-copy for mapped file)
+   nlohmann::json parseRange(const ByteRange& range)
    {
-      return this->cache[key];
+      if (mapped) {
+         const char* first = mapped->data() + range.begin;
+         return parseEntry(std::string_view(first, range.length()));
+      }
+      return parseEntry(readRange(range));
    }
 
-   // get key in json structured format (not REALLY const...)
-   const nlohmann::json& getKey(std::string key) const
+   void setTarget(nlohmann::json::json_pointer ptr)
    {
-      // sorry, this is quite fake, but necessary!
-      // I know what I'm doing!
-      VastJSON* me = const_cast<VastJSON*>(this);
-      return me->getKey(key);
+      while (!ptr.empty()) {
+         target.tokens.insert(target.tokens.begin(), ptr.back());
+         ptr.pop_back();
+      }
    }
 
-   // get key in json structured format
-   nlohmann::json& getKey(std::string key)
+   // load strict mode: top-level is indexed by (validating) skip scanner, then all entries are parsed in parallel
+   // (whole file is never parsed at once, and string of each entry is dropped as soon as it's parsed)
+   void loadStrict(std::istream& is)
    {
-      auto it = jsons.find(key);
-      if (it != jsons.end()) {
-         return jsons[key];
-      }
-      auto it2 = cache.find(key);
-      if (it2 == cache.end()) {
-         // CHECK IF THERE'S MORE TO READ IN 'ifsptr'
-         if (ifsptr) {
-            // must cache all available entries (to calculate 'size()')
-            cacheUntil(*ifsptr, count_par_ifsptr, key);
-            // IF stream has been consumed, drop its memory pointer
-            if (ifsptr->eof())
-               ifsptr = std::unique_ptr<std::ifstream>();
-            // try again and update iterator
-            it2 = cache.find(key);
-            if (it2 == cache.end()) {
-               // NOTHING ELSE TO DO... KEY DOES NOT EXIST!
-               //
-               //std::cerr << "BigJSON::getKey() error: key '" << key << "' does not exist!" << std::endl;
-            }
-         }
-      }
-      if (cache[key] == "") {
-         //std::cerr << "BigJSON::getKey() error: key '" << key << "' is empty or has been unloaded!" << std::endl;
+      this->cache.clear(); // start empty
+      this->jsons.clear(); // start empty
+      this->packed.clear();
+      this->cache_bytes = 0;
+      if (spill)
+         spill->clear();
+      {
+         BlockReader r(&is);
+         cacheStrict(r, true);
       }
-
-      // TODO: continue even with error (or return 'optional' for recovery?)
-      assert(cache[key].length() > 0);
-      jsons[key] = nlohmann::json::parse(std::move(cache[key]));
-      cache[key] = "";
-      return jsons[key];
+      loadAll();
    }
 
-   // unload json structure and do not keep string cache
-   void unload(std::string key)
+   // load strict mode over memory mapped file (entries are byte ranges of mapping)
+   void loadStrictMapped()
    {
-      cache[key] = ""; // mark as empty
-      auto it = jsons.find(key);
-      if (it == jsons.end()) {
-         //std::cerr << "BigJSON::unload() error: json key '" << key << "' does not exist!" << std::endl;
+      {
+         MemoryStreamBuf buf(mapped->data(), mapped->size());
+         std::istream is(&buf);
+         BlockReader r(&is);
+         cacheStrict(r, false); // positions on reader are offsets on mapping
       }
-      jsons.erase(it); // drop json structure
-      cache[key] = ""; // mark as empty
+      mscan.started = true;
+      mapped_pos = mapped->size();
+      loadAll();
    }
 
-   // move json structure back to string cache (since json structured format may be more memory costly)
-   void toCache(std::string key)
+   // validates whole document as a root object (only whitespace after it), storing each top-level
+   // entry as string ('copy') or as byte range. throws 'nlohmann::json::parse_error' on bad syntax.
+   void cacheStrict(BlockReader& is, bool copy)
    {
-      auto it = jsons.find(key);
-      if (it == jsons.end()) {
-         //std::cerr << "BigJSON::toCache() error: json key '" << key << "' does not exist!" << std::endl;
+      auto fail = [&is](const std::string& what) {
+         throw nlohmann::json::parse_error::create(101, std::size_t(is.tellg()), what + " (mode: BIG_STRICT)", nlohmann::json());
+      };
+      trim(is);
+      if (is.get() != '{')
+         fail("expected '{' as root");
+      trim(is);
+      if (is.peek() == '}')
+         is.get(); // empty root
+      else {
+         while (true) {
+            std::string key;
+            if ((is.peek() != '\"') || !skipJSONElement(is, &key))
+               fail("expected string as top-level key");
+            key = nlohmann::json::parse(key).get<std::string>(); // unescaped key
+            trim(is);
+            if (is.get() != ':')
+               fail("expected ':' after key '" + key + "'");
+            trim(is);
+            ByteRange range;
+            range.begin = is.tellg();
+            std::string raw;
+            if (!skipJSONElement(is, copy ? &raw : nullptr))
+               fail("bad value on key '" + key + "'");
+            range.end = is.tellg();
+            if (copy)
+               storeCache(key, std::move(raw));
+            else
+               storeOffset(key, range);
+            trim(is);
+            int c = is.get();
+            if (c == '}')
+               break;
+            if (c != ',')
+               fail("expected ',' or '}' after key '" + key + "'");
+            trim(is);
+         }
       }
-      //
-      std::stringstream ssjson;
-      ssjson << jsons[key];
-      unload(key);               // unload json structure
-      cache[key] = ssjson.str(); // keep string in cache
+      trim(is);
+      if (is.peek() != EOF)
+         fail("unexpected content after root");
    }
 
-   // ======================
-   //     constructors
-   // ======================
-
-private:
-   // load strict mode (manually parse whole file)
+   // load strict mode (over string, with no copy)
    void loadStrict(std::string& str)
    {
-      this->cache.clear(); // start empty
-      this->jsons.clear(); // start empty
-      nlohmann::json jstrict = nlohmann::json::parse(str);
-      str = "";
-      for (nlohmann::json::iterator it = jstrict.begin(); it != jstrict.end(); ++it) {
-         this->cache[it.key()] = "";
-         this->jsons[it.key()] = it.value();
+      {
+         MemoryStreamBuf buf(str.data(), str.length());
+         std::istream is(&buf);
+         loadStrict(is);
       }
+      std::string().swap(str);
    }
 
    // load strict mode (directly from ifsptr)
@@ -329,16 +3051,11 @@ private:
          this->hasError = true;
          return; // no stream
       }
-      std::istream& is = *ifsptr;
-      if (!is) {
-         // nothing to read from stream, drop stream
-         ifsptr = nullptr; // TODO: is this really important? For now, I think so.
-         return;
-      }
-      //
-      std::string str(std::istreambuf_iterator<char>(is), {});
+      std::unique_ptr<std::istream> is = std::move(ifsptr);
       ifsptr = nullptr; // TODO: is this really important? For now, I think so.
-      loadStrict(str);
+      if (!*is)
+         return; // nothing to read from stream, drop stream
+      loadStrict(*is);
    }
 
 public:
@@ -355,7 +3072,8 @@ public:
       if (mode == BIG_STRICT) {
          loadStrict(str);
       } else {
-         std::istringstream is(str);
+         MemoryStreamBuf buf(str.data(), str.length());
+         std::istream is(&buf);
          int count_par = 0; // reading from level 0
          cacheUntil(is, count_par);
       }
@@ -366,8 +3084,7 @@ public:
      : mode{ _mode }
    {
       if (mode == BIG_STRICT) {
-         std::string str(std::istreambuf_iterator<char>(is), {});
-         loadStrict(str);
+         loadStrict(is);
       } else {
          int count_par = 0; // reading from level 0
          cacheUntil(is, count_par);
@@ -375,8 +3092,9 @@ public:
    }
 
    // lazy processing
-   VastJSON(std::unique_ptr<std::istream>&& _ifsptr, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC)
+   VastJSON(std::unique_ptr<std::istream>&& _ifsptr, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC, CacheVastJSON _cacheMode = CacheVastJSON::CACHE_STRING)
      : mode{ _mode }
+     , cacheMode{ _cacheMode }
      , ifsptr{ std::move(_ifsptr) }
    {
       assert(ifsptr->good());
@@ -385,8 +3103,9 @@ public:
    }
 
    // lazy processing
-   VastJSON(std::ifstream&& _if, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC)
+   VastJSON(std::ifstream&& _if, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC, CacheVastJSON _cacheMode = CacheVastJSON::CACHE_STRING)
      : mode{ _mode }
+     , cacheMode{ _cacheMode }
      , ifsptr{ new std::ifstream{ std::move(_if) } }
    {
       assert(ifsptr->good());
@@ -395,8 +3114,9 @@ public:
    }
 
    // lazy processing: transfer ownership of _if to VastJSON
-   VastJSON(std::istream* _if, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC)
+   VastJSON(std::istream* _if, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC, CacheVastJSON _cacheMode = CacheVastJSON::CACHE_STRING)
      : mode{ _mode }
+     , cacheMode{ _cacheMode }
      , ifsptr{ _if }
    {
       assert(ifsptr->good());
@@ -404,16 +3124,66 @@ public:
          loadStrictFromIfsptr();
    }
 
+   // lazy processing over memory mapped file (entries are zero-copy slices of mapping)
+   VastJSON(MappedFile&& _mapped, ModeVastJSON _mode = ModeVastJSON::BIG_ROOT_DICT_GENERIC)
+     : mode{ _mode }
+     , cacheMode{ CacheVastJSON::CACHE_OFFSET }
+     , mapped{ new MappedFile{ std::move(_mapped) } }
+   {
+      if (!mapped->isOpen()) {
+         std::cerr << "WARNING: VastJSON cannot map file '" << mapped->getPath() << "'" << std::endl;
+         this->hasError = true;
+      } else if (mode == BIG_STRICT) {
+         // validating index over mapping, then all entries are parsed in parallel
+         loadStrictMapped();
+      }
+   }
+
+   // lazy processing of target element (mode BIG_TARGET_ELEMENT): its children are the top-level entries
+   VastJSON(std::unique_ptr<std::istream>&& _ifsptr, nlohmann::json::json_pointer _target, CacheVastJSON _cacheMode = CacheVastJSON::CACHE_STRING)
+     : VastJSON(std::move(_ifsptr), ModeVastJSON::BIG_TARGET_ELEMENT, _cacheMode)
+   {
+      setTarget(_target);
+   }
+
+   // lazy processing of target element (mode BIG_TARGET_ELEMENT): transfer ownership of _if to VastJSON
+   VastJSON(std::istream* _if, nlohmann::json::json_pointer _target, CacheVastJSON _cacheMode = CacheVastJSON::CACHE_STRING)
+     : VastJSON(_if, ModeVastJSON::BIG_TARGET_ELEMENT, _cacheMode)
+   {
+      setTarget(_target);
+   }
+
    ~VastJSON()
    {
+      stopPrefetch();
    }
 
+   // background indexer of 'corpse' is stopped (since it works over 'corpse')
    VastJSON(VastJSON&& corpse)
-     : mode{ corpse.mode }
+     : mode{ (corpse.stopPrefetch(), corpse.mode) }
+     , cacheMode{ corpse.cacheMode }
+     , jsons{ std::move(corpse.jsons) }
+     , cache{ std::move(corpse.cache) }
+     , offsets{ std::move(corpse.offsets) }
+     , packed{ std::move(corpse.packed) }
+     , codec{ std::move(corpse.codec) }
      , ifsptr{ std::move(corpse.ifsptr) }
+     , reader{ std::move(corpse.reader) }
+     , srcptr{ std::move(corpse.srcptr) }
+     , mapped{ std::move(corpse.mapped) }
+     , mapped_pos{ corpse.mapped_pos }
+     , mscan{ std::move(corpse.mscan) }
+     , count_par_ifsptr{ corpse.count_par_ifsptr }
+     , next_index{ corpse.next_index }
+     , target{ std::move(corpse.target) }
+     , findex{ std::move(corpse.findex) }
+     , lru{ std::move(corpse.lru) }
+     , concurrent{ std::move(corpse.concurrent) }
+     , spill{ std::move(corpse.spill) }
+     , cache_bytes{ corpse.cache_bytes.load() }
+     , stats{ std::move(corpse.stats) }
+     , hasError{ corpse.hasError }
    {
-      // TODO: STEAL the rest
-      assert(ifsptr->good());
    }
 
    VastJSON& operator=(VastJSON&& other_corpse)
@@ -422,31 +3192,36 @@ public:
          return *this; // self-check
       //
       clear(); // kill everything
+      other_corpse.stopPrefetch();
       //
       this->mode = other_corpse.mode;
+      this->cacheMode = other_corpse.cacheMode;
       this->jsons = std::move(other_corpse.jsons);
       this->cache = std::move(other_corpse.cache);
+      this->offsets = std::move(other_corpse.offsets);
+      this->packed = std::move(other_corpse.packed);
+      this->codec = std::move(other_corpse.codec);
       this->ifsptr = std::move(other_corpse.ifsptr);
+      this->reader = std::move(other_corpse.reader);
+      this->srcptr = std::move(other_corpse.srcptr);
+      this->mapped = std::move(other_corpse.mapped);
+      this->mapped_pos = other_corpse.mapped_pos;
+      this->mscan = std::move(other_corpse.mscan);
       this->count_par_ifsptr = std::move(other_corpse.count_par_ifsptr);
+      this->next_index = other_corpse.next_index;
+      this->target = std::move(other_corpse.target);
+      this->findex = std::move(other_corpse.findex);
+      this->lru = std::move(other_corpse.lru);
+      this->concurrent = std::move(other_corpse.concurrent);
+      this->spill = std::move(other_corpse.spill);
+      this->cache_bytes = other_corpse.cache_bytes.load();
+      this->stats = std::move(other_corpse.stats);
       //
       return *this;
    }
 
 private:
-   std::string getStringIdentifier(std::string& before)
-   {
-      //std::cout << "getStringIdentifier('" << before << "')" << std::endl;
-      unsigned keyStart = before.find('\"') + 1;
-      std::string rest = before.substr(keyStart, before.length());
-      //std::cout << "rest = '" << rest << "'" << std::endl;
-      std::istringstream is(rest);
-      std::string str = "\"";
-      getString(str, is);
-      //std::cout << "final string: '" << str << "'" << std::endl;
-      return str;
-   }
-
-   void getString(std::string& str, std::istream& is)
+   void getString(std::string& str, BlockReader& is)
    {
       char c;
       while (is.get(c)) {
@@ -464,59 +3239,180 @@ private:
       }
    }
    //
-   nlohmann::json getJSONElement(std::istream& is)
+   // reads exactly one json value from stream, in a single (non-strict) SAX pass: parsing stops
+   // at the end of the value, so no exception is thrown on the following ',' (nor any re-parse).
+   // only numbers are delimited by a lookahead char, which is put back on stream.
+   nlohmann::json getJSONElement(BlockReader& is)
    {
-      char last = '\0';
-      auto sptr = std::make_shared<CacheStream>(CacheStream(&is));
+      CacheStream cs(&is);
       nlohmann::json jj6;
-      std::string again;
-      bool bad = false;
-      try {
-         jj6 = nlohmann::json::parse(sptr);
-      } catch (std::exception& e) {
-         again = sptr->cache;
-         last = again[again.length() - 1];
-         again.pop_back();
-         bad = true;
-      }
-      //
-      if (bad) {
-         try {
-            jj6 = nlohmann::json::parse(again);
-         } catch (std::exception& e) {
-            //std::cout << "REALLY BAD READ! NO TRY AGAIN..." << std::endl;
-         }
+      nlohmann::detail::json_sax_dom_parser<nlohmann::json> sax(jj6, false);
+      nlohmann::detail::parser<nlohmann::json, CacheStreamRef> p(CacheStreamRef{ &cs }, nullptr, false);
+      if (!p.sax_parse(&sax, false)) {
+         std::cerr << "WARNING: VastJSON failed to read json element" << std::endl;
+         this->hasError = true;
+         return nlohmann::json();
       }
-      //
-      //std::cout << "LAST(PUTBACK) = '" << last << "'" << std::endl;
-      is.putback(last);
+      if (jj6.is_number() && !cs.eof)
+         is.unget();
       return jj6;
    }
    //
-   //void trim(std::istream& is, char& pk) {
-   void trim(std::istream& is)
+   // skips exactly one json value from stream, with no json built (nor re-serialized): strings and
+   // brackets are matched, and numbers and literals are checked. raw text is appended to 'raw' (if given).
+   // stream stops right after the value (numbers are delimited by peek). returns false on bad syntax.
+   bool skipJSONElement(BlockReader& is, std::string* raw)
    {
-      char pk = is.peek();
-      //std::cout << "trim(pk='" << pk << "')" << std::endl;
-      if (!pk)
-         return; // EOF
-      // consume spaces and non-visible chars
-      while ((pk == ' ') || (pk == '\t') || (pk == '\r') || (pk == '\n')) // TODO: more here?
-      {
-         int gc = is.get();
-         gc = gc;
-         //std::cout << "gc='" << gc<< "' pk='" << pk << "'" << std::endl;
-         //assert(gc == pk); // OBVIOUS TRUTH!
-         pk = is.peek();
-         if (!pk)
-            return; // EOF
+      auto put = [raw](char c) {
+         if (raw)
+            raw->push_back(c);
+      };
+      auto spaces = [&is, &put]() {
+         while (isSpace(char(is.peek())))
+            put(char(is.get()));
+      };
+      auto digits = [&is, &put]() {
+         int n = 0;
+         while (std::isdigit(is.peek())) {
+            put(char(is.get()));
+            n++;
+         }
+         return n;
+      };
+      skip_stack.clear();
+      bool key = false; // next value is an object key
+      while (true) {
+         spaces();
+         int c = is.get();
+         if (c == EOF)
+            return false;
+         put(char(c));
+         if (key && (c != '\"'))
+            return false;
+         if ((c == '{') || (c == '[')) {
+            spaces();
+            int close = (c == '{') ? '}' : ']';
+            if (is.peek() == close) {
+               put(char(is.get())); // empty container
+            } else {
+               skip_stack.push_back(char(close));
+               key = (c == '{');
+               continue;
+            }
+         } else if (c == '\"') {
+            // string (control chars are not allowed, escapes are checked)
+            while (true) {
+               c = is.get();
+               if ((c == EOF) || ((unsigned char)c < 0x20))
+                  return false;
+               put(char(c));
+               if (c == '\"')
+                  break;
+               if (c == '\\') {
+                  c = is.get();
+                  if ((c == EOF) || (c == 0) || !std::strchr("\"\\/bfnrtu", c))
+                     return false;
+                  put(char(c));
+                  for (int k = 0; (c == 'u') && (k < 4); k++) {
+                     if (!std::isxdigit(is.peek()))
+                        return false;
+                     put(char(is.get()));
+                  }
+               }
+            }
+            if (key) {
+               // object key must be followed by ':'
+               spaces();
+               if (is.get() != ':')
+                  return false;
+               put(':');
+               key = false;
+               continue;
+            }
+         } else if ((c == '-') || std::isdigit(c)) {
+            // number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+            if (c == '-') {
+               c = is.get();
+               if (!std::isdigit(c))
+                  return false;
+               put(char(c));
+            }
+            // no leading zeros
+            if (c != '0')
+               digits();
+            else if (std::isdigit(is.peek()))
+               return false;
+            if (is.peek() == '.') {
+               put(char(is.get()));
+               if (digits() == 0)
+                  return false;
+            }
+            if ((is.peek() == 'e') || (is.peek() == 'E')) {
+               put(char(is.get()));
+               if ((is.peek() == '+') || (is.peek() == '-'))
+                  put(char(is.get()));
+               if (digits() == 0)
+                  return false;
+            }
+         } else if ((c == 't') || (c == 'f') || (c == 'n')) {
+            const char* lit = (c == 't') ? "true" : ((c == 'f') ? "false" : "null");
+            for (const char* l = lit + 1; *l; l++) {
+               if (is.get() != *l)
+                  return false;
+               put(*l);
+            }
+         } else
+            return false;
+         // value is finished: close containers, or go to next member
+         while (true) {
+            if (skip_stack.empty())
+               return true;
+            spaces();
+            c = is.get();
+            if (c == EOF)
+               return false;
+            put(char(c));
+            if (c == skip_stack.back()) {
+               skip_stack.pop_back();
+            } else if (c == ',') {
+               key = (skip_stack.back() == '}');
+               break;
+            } else
+               return false;
+         }
       }
-      //
+   }
+   //
+   // consume spaces and non-visible chars
+   void trim(BlockReader& is)
+   {
+      while (isSpace(char(is.peek())))
+         is.get();
    }
 
 public:
    // perform string caching until 'targetKey' is found (or stream is ended)
+   // (chars read ahead from streams other than pending one are given back, if stream is seekable)
    void cacheUntil(std::istream& is, int& count_par, std::string targetKey = "", int count_keys = -1)
+   {
+      if (ifsptr && (&is == ifsptr.get())) {
+         if (!reader)
+            reader.reset(new BlockReader(ifsptr.get()));
+         cacheUntil(*reader, count_par, targetKey, count_keys);
+         return;
+      }
+      BlockReader r(&is);
+      cacheUntil(r, count_par, targetKey, count_keys);
+      r.release();
+   }
+
+private:
+   void cacheUntil(BlockReader& is, int& count_par, std::string targetKey, int count_keys)
+   {
+      measureScan([&is]() { return is.tellg(); }, [&]() { cacheUntilMode(is, count_par, targetKey, count_keys); });
+   }
+
+   void cacheUntilMode(BlockReader& is, int& count_par, std::string targetKey, int count_keys)
    {
       if (mode == ModeVastJSON::BIG_ROOT_DICT_NO_ROOT_LIST) {
          cacheUntilNoRootList(is, count_par, targetKey, count_keys);
@@ -524,6 +3420,20 @@ public:
       } else if (mode == ModeVastJSON::BIG_ROOT_DICT_GENERIC) {
          cacheUntilGeneric(is, count_par, targetKey, count_keys);
          return;
+      } else if (mode == ModeVastJSON::BIG_ROOT_LIST) {
+         cacheUntilList(is, count_par, targetKey, count_keys);
+         return;
+      } else if (mode == ModeVastJSON::BIG_JSON_LINES) {
+         cacheUntilLines(is, targetKey, count_keys);
+         return;
+      } else if (mode == ModeVastJSON::BIG_TARGET_ELEMENT) {
+         if (target.stage == 0)
+            enterTarget(is);
+         if ((target.stage == 1) && target.list)
+            cacheUntilList(is, count_par, targetKey, count_keys);
+         else if (target.stage == 1)
+            cacheUntilGeneric(is, count_par, targetKey, count_keys);
+         return;
       } else if (mode == ModeVastJSON::BIG_STRICT) {
          // nothing to do (already loaded)
          return;
@@ -534,12 +3444,343 @@ public:
    }
 
 private:
-   // IMPLEMENTATION THAT ALLOWS GENERIC JSON (SLOWER...)
-   void cacheUntilGeneric(std::istream& is, int& count_par, std::string targetKey, int count_keys)
+   static bool isSpace(char c)
    {
-      std::string before;
-      std::string content;
+      return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+   }
+
+   // IMPLEMENTATION OVER MAPPED FILE (zero-copy structural indexing, both modes BIG_ROOT_DICT_*)
+   void cacheUntilMapped(std::string targetKey, int count_keys)
+   {
+      const char* begin = mapped->data();
+      std::size_t n = mapped->size();
+      RootScanState& st = mscan;
+      //
+      if (!st.started) {
+         st.started = true;
+         std::size_t first = 0;
+         while ((first < n) && isSpace(begin[first]))
+            first++;
+         if ((first < n) && (begin[first] != rootChar())) {
+            // must be a list or primary element
+            storeJSON("", nlohmann::json::parse(begin + first, begin + n));
+            mapped_pos = n;
+            return;
+         }
+      }
+      //
+      while (true) {
+         if (st.bits == 0) {
+            if (st.next_block >= n) {
+               mapped_pos = n; // finished
+               return;
+            }
+            st.block = st.next_block;
+            st.next_block += StructuralIndexer::BLOCK_SIZE;
+            if (st.next_block <= n) {
+               st.bits = st.indexer.next(begin + st.block);
+            } else {
+               // last partial block: pad with spaces
+               char padded[StructuralIndexer::BLOCK_SIZE];
+               std::fill(padded, padded + StructuralIndexer::BLOCK_SIZE, ' ');
+               std::copy(begin + st.block, begin + n, padded);
+               st.bits = st.indexer.next(padded);
+            }
+            continue;
+         }
+         std::size_t pos = st.block + StructuralIndexer::trailingZeros(st.bits);
+         st.bits &= st.bits - 1;
+         mapped_pos = pos + 1;
+         char c = begin[pos];
+         int result = onStructural(c, pos, st.depth);
+         if ((c == '{') || (c == '['))
+            st.depth++;
+         else if ((c == '}') || (c == ']'))
+            st.depth--;
+         //
+         if (result == 2) {
+            mapped_pos = n; // finished
+            return;
+         }
+         if (result == 1) {
+            // if 'targetKey' is found, stop reading
+            if ((targetKey != "") && (mscan.key == targetKey))
+               return;
+            // check if count_keys is enabled (>= 0)
+            if ((count_keys >= 0) && (--count_keys == 0))
+               return;
+         }
+      }
+   }
+
+   // handle structural char 'c' at 'pos' of mapped file, on 'depth' (before 'c')
+   // returns 1 if an entry is stored, 2 if root is finished (or aborted), and 0 otherwise
+   int onStructural(char c, std::size_t pos, int depth)
+   {
+      if (mode == BIG_ROOT_LIST)
+         return onListStructural(c, pos, depth);
+      RootScanState& st = mscan;
+      if ((c == '{') || (c == '[')) {
+         if ((depth == 1) && (st.step != 3)) {
+            std::cerr << "WARNING: VastJSON failed to get field on mapped file" << std::endl;
+            this->hasError = true;
+         } else if ((depth == 1) && (c == '[') && (mode == BIG_ROOT_DICT_NO_ROOT_LIST)) {
+            std::cerr << "WARNING: VastJSON found list as top-level entry (mode: BIG_ROOT_DICT_NO_ROOT_LIST)" << std::endl;
+            this->hasError = true;
+         }
+         return 0;
+      }
+      if ((c == '}') || (c == ']')) {
+         if (depth != 1)
+            return 0;
+         // end of root
+         if (st.step == 3)
+            storeMapped(pos);
+         return 2;
+      }
+      if (depth != 1)
+         return 0; // nothing to do inside top-level values
+      if (c == '"') {
+         if (st.step == 0) {
+            st.key_begin = pos + 1;
+            st.step = 1;
+         } else if (st.step == 1) {
+            st.key.assign(mapped->data() + st.key_begin, mapped->data() + pos);
+            st.step = 2;
+         }
+      } else if (c == ':') {
+         if (st.step != 2) {
+            std::cerr << "WRONG DELIMITER! ABORT!" << std::endl;
+            this->hasError = true;
+            return 2;
+         }
+         st.value_begin = pos + 1;
+         st.step = 3;
+      } else if (c == ',') {
+         bool stored = (st.step == 3);
+         if (stored)
+            storeMapped(pos);
+         st.step = 0;
+         return stored ? 1 : 0;
+      }
+      return 0;
+   }
+
+   // handle structural char 'c' at 'pos' of mapped file, on 'depth' (before 'c'), for BIG_ROOT_LIST
+   int onListStructural(char c, std::size_t pos, int depth)
+   {
+      RootScanState& st = mscan;
+      if (((c == '{') || (c == '[')) && (depth == 0)) {
+         // root list is opened
+         st.value_begin = pos + 1;
+         return 0;
+      }
+      bool last = ((c == '}') || (c == ']'));
+      if ((depth != 1) || ((c != ',') && !last))
+         return 0; // nothing to do inside list elements
+      // element ends here (only an empty list has no last element)
+      st.key = std::to_string(next_index);
+      bool stored = storeMapped(pos);
+      if (stored)
+         next_index++;
+      st.value_begin = pos + 1;
+      if (last)
+         return 2;
+      return stored ? 1 : 0;
+   }
+
+   // IMPLEMENTATION OVER MAPPED FILE FOR JSON LINES (newline scan with memchr)
+   void cacheUntilMappedLines(std::string targetKey, int count_keys)
+   {
+      const char* begin = mapped->data();
+      std::size_t n = mapped->size();
+      mscan.started = true;
+      while (mapped_pos < n) {
+         const char* nl = static_cast<const char*>(std::memchr(begin + mapped_pos, '\n', n - mapped_pos));
+         std::size_t line_end = nl ? std::size_t(nl - begin) : n;
+         mscan.value_begin = mapped_pos;
+         mapped_pos = nl ? line_end + 1 : n;
+         mscan.key = std::to_string(next_index);
+         if (!storeMapped(line_end))
+            continue; // empty line
+         next_index++;
+         // if 'targetKey' is found, stop reading
+         if ((targetKey != "") && (mscan.key == targetKey))
+            return;
+         // check if count_keys is enabled (>= 0)
+         if ((count_keys >= 0) && (--count_keys == 0))
+            return;
+      }
+   }
+
+   // PARALLEL IMPLEMENTATION OVER MAPPED FILE FOR JSON LINES (newlines of each chunk are found in parallel)
+   void cacheMappedLinesParallel(unsigned nthreads, std::size_t chunk_size)
+   {
+      const char* begin = mapped->data();
+      std::size_t n = mapped->size();
+      mscan.started = true;
+      std::size_t nchunks = std::max<std::size_t>(1, n / chunk_size);
+      std::vector<std::vector<std::size_t>> newlines(nchunks);
+      parallelFor(nchunks, nthreads, [&](std::size_t i) {
+         std::size_t p = n / nchunks * i;
+         std::size_t cend = (i + 1 == nchunks) ? n : n / nchunks * (i + 1);
+         while (const char* nl = static_cast<const char*>(std::memchr(begin + p, '\n', cend - p))) {
+            newlines[i].push_back(nl - begin);
+            p = (nl - begin) + 1;
+         }
+      });
+      for (std::size_t i = 0; i < nchunks; i++) {
+         for (std::size_t line_end : newlines[i]) {
+            mscan.value_begin = mapped_pos;
+            mscan.key = std::to_string(next_index);
+            if (storeMapped(line_end))
+               next_index++;
+            mapped_pos = line_end + 1;
+         }
+         std::vector<std::size_t>().swap(newlines[i]); // release memory
+      }
+      // last line (with no newline)
+      mscan.value_begin = mapped_pos;
+      mscan.key = std::to_string(next_index);
+      if (storeMapped(n))
+         next_index++;
+      mapped_pos = n;
+   }
+
+   // expected first char of root (for root dict/list modes)
+   char rootChar() const
+   {
+      return (mode == BIG_ROOT_LIST) ? '[' : '{';
+   }
+
+   // visit chunk [cbegin, cend) of mapped file, calling 'fn(offset, block)' for each 64-byte block (last one is padded)
+   template<class F>
+   void scanMappedChunk(std::size_t cbegin, std::size_t cend, F fn)
+   {
+      const char* begin = mapped->data();
+      for (std::size_t b = cbegin; b < cend; b += StructuralIndexer::BLOCK_SIZE) {
+         if (b + StructuralIndexer::BLOCK_SIZE <= cend) {
+            fn(b, begin + b);
+         } else {
+            char padded[StructuralIndexer::BLOCK_SIZE];
+            std::fill(padded, padded + StructuralIndexer::BLOCK_SIZE, ' ');
+            std::copy(begin + b, begin + cend, padded);
+            fn(b, padded);
+         }
+      }
+   }
+
+   // PARALLEL IMPLEMENTATION OVER MAPPED FILE (whole file is indexed)
+   // 1) each chunk is scanned speculatively (starting outside and inside a string), computing depth change;
+   // 2) chunk start states are resolved sequentially;
+   // 3) each chunk is scanned again from its real state, keeping only structural chars on depths 0 and 1;
+   // 4) these few structural chars are merged (in order) into top-level entries.
+   void cacheMappedParallel(unsigned nthreads, std::size_t chunk_size)
+   {
+      const char* begin = mapped->data();
+      std::size_t n = mapped->size();
+      std::size_t first = 0;
+      while ((first < n) && isSpace(begin[first]))
+         first++;
+      if ((first >= n) || (begin[first] != rootChar()))
+         return; // not a root dict/list (sequential scan will handle it)
+      mscan.started = true;
       //
+      std::size_t nchunks = std::max<std::size_t>(1, n / chunk_size);
+      // chunk bounds (a chunk never starts on an escaped char)
+      std::vector<std::size_t> bounds(nchunks + 1, n);
+      bounds[0] = 0;
+      for (std::size_t i = 1; i < nchunks; i++) {
+         std::size_t b = std::max(bounds[i - 1], n / nchunks * i);
+         while ((b < n) && (b > 0) && (begin[b - 1] == '\\'))
+            b++;
+         bounds[i] = b;
+      }
+      // 1) speculative depth change, for chunk starting outside [0] and inside [1] a string
+      struct ChunkSummary
+      {
+         int delta[2]{ 0, 0 };
+         bool end_in_string[2]{ false, true };
+      };
+      std::vector<ChunkSummary> summary(nchunks);
+      parallelFor(nchunks, nthreads, [&](std::size_t i) {
+         StructuralIndexer indexer;
+         ChunkSummary& sum = summary[i];
+         scanMappedChunk(bounds[i], bounds[i + 1], [&](std::size_t, const char* block) {
+            std::uint64_t quote, backslash, op;
+            StructuralIndexer::classify(block, quote, backslash, op);
+            quote &= ~indexer.findEscaped(backslash);
+            // in string for state [0] (state [1] is the complement)
+            std::uint64_t in_string = StructuralIndexer::prefixXor(quote) ^ (sum.end_in_string[0] ? ~std::uint64_t(0) : 0);
+            sum.end_in_string[0] = (std::int64_t(in_string) < 0);
+            sum.end_in_string[1] = !sum.end_in_string[0];
+            for (std::uint64_t bits = op; bits; bits &= bits - 1) {
+               int k = StructuralIndexer::trailingZeros(bits);
+               char c = block[k];
+               int d = ((c == '{') || (c == '[')) ? 1 : (((c == '}') || (c == ']')) ? -1 : 0);
+               sum.delta[(in_string >> k) & 1] += d;
+            }
+         });
+      });
+      // 2) resolve start state and depth of each chunk
+      std::vector<bool> start_in_string(nchunks, false);
+      std::vector<int> start_depth(nchunks, 0);
+      for (std::size_t i = 0; i + 1 < nchunks; i++) {
+         int sp = start_in_string[i] ? 1 : 0;
+         start_in_string[i + 1] = summary[i].end_in_string[sp];
+         start_depth[i + 1] = start_depth[i] + summary[i].delta[sp];
+      }
+      // 3) structural chars on depths 0 and 1 (with depth before them)
+      std::vector<std::vector<std::pair<std::size_t, int>>> events(nchunks);
+      parallelFor(nchunks, nthreads, [&](std::size_t i) {
+         StructuralIndexer indexer{ start_in_string[i] };
+         int depth = start_depth[i];
+         scanMappedChunk(bounds[i], bounds[i + 1], [&](std::size_t b, const char* block) {
+            for (std::uint64_t bits = indexer.next(block); bits; bits &= bits - 1) {
+               int k = StructuralIndexer::trailingZeros(bits);
+               char c = block[k];
+               if (depth <= 1)
+                  events[i].emplace_back(b + k, depth);
+               if ((c == '{') || (c == '['))
+                  depth++;
+               else if ((c == '}') || (c == ']'))
+                  depth--;
+            }
+         });
+      });
+      // 4) merge entries in order
+      for (std::size_t i = 0; i < nchunks; i++) {
+         for (auto& ev : events[i]) {
+            if (onStructural(begin[ev.first], ev.first, ev.second) == 2) {
+               mapped_pos = n; // finished
+               return;
+            }
+         }
+         std::vector<std::pair<std::size_t, int>>().swap(events[i]); // release memory
+      }
+      mapped_pos = n;
+   }
+
+   // store top-level entry of mapped file, with value ending on 'value_end' (nothing is stored for empty values)
+   bool storeMapped(std::size_t value_end)
+   {
+      const char* begin = mapped->data();
+      ByteRange range;
+      range.begin = mscan.value_begin;
+      range.end = value_end;
+      while ((range.begin < range.end) && isSpace(begin[range.begin]))
+         range.begin++;
+      while ((range.end > range.begin) && isSpace(begin[range.end - 1]))
+         range.end--;
+      if (range.length() == 0)
+         return false;
+      storeOffset(mscan.key, range);
+      return true;
+   }
+
+   // IMPLEMENTATION THAT ALLOWS GENERIC JSON (SLOWER...)
+   void cacheUntilGeneric(BlockReader& is, int& count_par, std::string targetKey, int count_keys)
+   {
       // DETECT MODE
       // MODE 1 - { or }
       // MODE 2 - general (int, string, list)
@@ -552,13 +3793,16 @@ private:
       pk = is.peek();
 
       // try to detect mode 2 (should not be '{' or continuation char ',')
-      if ((pk != '{') && (pk != ',')) {
+      // (only once: when resuming, stream may be on final '}')
+      if ((count_par == 0) && (pk != '{') && (pk != ',')) {
          // must be a list or primary element
          nlohmann::json jout = getJSONElement(is);
-         jsons[""] = jout;
-         cache[""] = "";
+         storeJSON("", std::move(jout));
+         if (mode == BIG_TARGET_ELEMENT)
+            leaveTarget(is);
          return;
       }
+      count_par = 1;
 
       // this is mode 1: first symbol must be '{'
       while (true) {
@@ -566,6 +3810,11 @@ private:
          char c;
          if (!is.get(c))
             break; // EOF
+         if ((c == '}') && (mode == BIG_TARGET_ELEMENT)) {
+            // target object is finished
+            leaveTarget(is);
+            break;
+         }
 
          // LOOK FOR IDENTIFIER
          if (c != '\"') {
@@ -597,22 +3846,32 @@ private:
             trim(is);
             pk = is.peek();
             //
-            nlohmann::json comp = getJSONElement(is);
+            // value is only skipped (raw text is kept, or just its offsets)
+            bool copy = (cacheMode != CACHE_OFFSET);
+            ByteRange range;
+            if (!copy)
+               range.begin = is.tellg();
+            std::string raw;
+            if (!skipJSONElement(is, copy ? &raw : nullptr)) {
+               std::cerr << "WARNING: VastJSON failed to read value (mode: BIG_ROOT_DICT_GENERIC)" << std::endl;
+               this->hasError = true;
+               break;
+            }
+            if (!copy)
+               range.end = is.tellg();
 
-            std::string str_id = getStringIdentifier(str);
-            std::string field_name = str_id.substr(1, str_id.length() - 2);
+            std::string field_name = str.substr(1, str.length() - 2);
             if (field_name == "") {
                std::cerr << "STRANGE: EMPTY ID!" << std::endl;
                assert(false);
             }
-            std::stringstream ss;
-            ss << comp;
-            comp = nlohmann::json();
-            //std::cout << "field_name: " << field_name << std::endl;
-            cache[field_name] = ss.str();
-            // TODO: delete 'ss' (AVOID LOSS OF MEMORY HERE)
-            content = ""; // implicit??
-            before = "";  // good?
+            if (!copy) {
+               // only keep offsets (value will be re-read from stream)
+               storeOffset(field_name, range);
+            } else {
+               //std::cout << "field_name: " << field_name << std::endl;
+               storeCache(field_name, std::move(raw));
+            }
             // =============
             // if 'targetKey' is found, stop reading
             if ((targetKey != "") && (field_name == targetKey)) {
@@ -640,86 +3899,339 @@ private:
       }
    }
 
+   // json pointer to container on 'level' of target path
+   nlohmann::json::json_pointer targetPrefix(std::size_t level)
+   {
+      nlohmann::json::json_pointer ptr;
+      for (std::size_t i = 0; i < level; i++)
+         ptr /= target.tokens[i];
+      return ptr;
+   }
+
+   // read next member of container on 'level' of target path (up to its value), with its key/position on 'token'
+   // returns false if container is closed
+   bool nextTargetMember(BlockReader& is, std::size_t level, std::string& token)
+   {
+      trim(is);
+      if (is.peek() == ',') {
+         is.get(); // consume ','
+         trim(is);
+      }
+      int pk = is.peek();
+      if ((pk == '}') || (pk == ']') || (pk == EOF)) {
+         is.get(); // consume closing
+         return false;
+      }
+      if (target.containers[level] == '[') {
+         token = std::to_string(target.indices[level]++);
+         return true;
+      }
+      std::string str;
+      if (is.get() == '\"') {
+         str = "\"";
+         getString(str, is);
+         trim(is);
+      }
+      if ((str == "") || (is.get() != ':')) {
+         std::cerr << "WARNING: VastJSON failed to get field (mode: BIG_TARGET_ELEMENT)" << std::endl;
+         this->hasError = true;
+         return false;
+      }
+      trim(is);
+      token = nlohmann::json::parse(str).get<std::string>(); // unescaped key
+      return true;
+   }
+
+   // navigate from root into target element, parsing siblings into 'outer' (for BIG_TARGET_ELEMENT)
+   void enterTarget(BlockReader& is)
+   {
+      target.stage = 1;
+      for (std::size_t level = 0; level < target.tokens.size(); level++) {
+         trim(is);
+         char open = is.get();
+         if ((open != '{') && (open != '[')) {
+            std::cerr << "WARNING: VastJSON target element not found (mode: BIG_TARGET_ELEMENT)" << std::endl;
+            this->hasError = true;
+            target.stage = 2;
+            is.ignore();
+            return;
+         }
+         target.containers.push_back(open);
+         target.indices.push_back(0);
+         nlohmann::json::json_pointer prefix = targetPrefix(level);
+         target.outer[prefix] = (open == '{') ? nlohmann::json::object() : nlohmann::json::array();
+         std::string token;
+         while (nextTargetMember(is, level, token) && (token != target.tokens[level]))
+            target.outer[prefix / token] = getJSONElement(is);
+         if (token != target.tokens[level]) {
+            std::cerr << "WARNING: VastJSON target element not found (mode: BIG_TARGET_ELEMENT)" << std::endl;
+            this->hasError = true;
+            target.stage = 2;
+            is.ignore();
+            return;
+         }
+      }
+      target.outer[targetPrefix(target.tokens.size())] = nullptr;
+      trim(is);
+      // list target is indexed as BIG_ROOT_LIST (nothing is cached yet, so order of keys can still change)
+      target.list = (is.peek() == '[');
+      if (cache.empty())
+         cache = std::map<std::string, std::string, KeyOrder>{ KeyOrder{ target.list } };
+   }
+
+   // leave target element, parsing remaining siblings into 'outer' (for BIG_TARGET_ELEMENT)
+   void leaveTarget(BlockReader& is)
+   {
+      target.stage = 2;
+      std::string token;
+      for (std::size_t level = target.containers.size(); level > 0; level--) {
+         nlohmann::json::json_pointer prefix = targetPrefix(level - 1);
+         while (nextTargetMember(is, level - 1, token))
+            target.outer[prefix / token] = getJSONElement(is);
+      }
+      // consume rest of stream
+      is.ignore();
+   }
+
+   // IMPLEMENTATION FOR JSON LINES (one entry per non-empty line, keyed by position)
+   void cacheUntilLines(BlockReader& is, std::string targetKey, int count_keys)
+   {
+      std::string line;
+      while (true) {
+         std::uint64_t line_begin = (cacheMode == CACHE_OFFSET) ? std::uint64_t(is.tellg()) : 0;
+         if (!is.getline(line))
+            break; // EOF
+         if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue; // empty line
+         std::string field_name = std::to_string(next_index++);
+         if (cacheMode == CACHE_OFFSET) {
+            ByteRange range;
+            range.begin = line_begin;
+            range.end = line_begin + line.length();
+            storeOffset(field_name, range);
+         } else {
+            storeCache(field_name, std::move(line));
+            line = "";
+         }
+         // if 'targetKey' is found, stop reading
+         if ((targetKey != "") && (field_name == targetKey))
+            break;
+         // check if count_keys is enabled (>= 0)
+         if ((count_keys >= 0) && (--count_keys == 0))
+            break;
+      }
+   }
+
+   // IMPLEMENTATION FOR BIG LISTS ON ROOT LEVEL (entries are keyed by position)
+   void cacheUntilList(BlockReader& is, int& count_par, std::string targetKey, int count_keys)
+   {
+      trim(is);
+      if (count_par == 0) {
+         // first symbol must be '['
+         char c;
+         if (!is.get(c) || (c != '[')) {
+            std::cerr << "WARNING: VastJSON failed to get list (mode: BIG_ROOT_LIST)" << std::endl;
+            this->hasError = true;
+            is.ignore();
+            return;
+         }
+         count_par = 1;
+      }
+      while (true) {
+         trim(is);
+         if (is.peek() == ',') {
+            is.get(); // consume ','
+            trim(is);
+         }
+         if ((is.peek() == ']') || (is.peek() == EOF)) {
+            count_par = 0;
+            if (mode == BIG_TARGET_ELEMENT) {
+               // target list is finished: parse siblings after it
+               is.get();
+               leaveTarget(is);
+               return;
+            }
+            // list is finished: consume rest of stream
+            is.ignore();
+            return;
+         }
+         //
+         // element is only skipped (raw text is kept, or just its offsets)
+         bool copy = (cacheMode != CACHE_OFFSET);
+         ByteRange range;
+         if (!copy)
+            range.begin = is.tellg();
+         std::string raw;
+         if (!skipJSONElement(is, copy ? &raw : nullptr)) {
+            std::cerr << "WARNING: VastJSON failed to read element (mode: BIG_ROOT_LIST)" << std::endl;
+            this->hasError = true;
+            is.ignore();
+            count_par = 0;
+            if (mode == BIG_TARGET_ELEMENT)
+               target.stage = 2;
+            return;
+         }
+         std::string field_name = std::to_string(next_index++);
+         if (!copy) {
+            range.end = is.tellg();
+            storeOffset(field_name, range);
+         } else
+            storeCache(field_name, std::move(raw));
+         // if 'targetKey' is found, stop reading
+         if ((targetKey != "") && (field_name == targetKey))
+            break;
+         // check if count_keys is enabled (>= 0)
+         if ((count_keys >= 0) && (--count_keys == 0))
+            break;
+      }
+   }
+
    // LEGACY IMPLEMENTATION THAT WON'T ALLOW LISTS ON ROOT LEVEL... (FASTER!)
-   void cacheUntilNoRootList(std::istream& is, int& count_par, std::string targetKey, int count_keys)
+   // stream blocks go through structural indexer (as mapped file), so strings may hold any braces or quotes.
+   // scan always stops right after a top-level value (outside strings), so indexer starts clean on each call.
+   void cacheUntilNoRootList(BlockReader& is, int& count_par, std::string targetKey, int count_keys)
    {
-      std::string before;
+      constexpr std::size_t BLOCK = StructuralIndexer::BLOCK_SIZE;
+      StructuralIndexer indexer;
+      bool copy = (cacheMode != CACHE_OFFSET);
+      // 0: key opening quote; 1: key closing quote; 2: colon; 3: value
+      int step = 0;
+      std::string key;
       std::string content;
-      //
-      int target_field = 1; // starts from 1
-      bool save = false;
-      //
+      // byte range of value (only for CACHE_OFFSET), with 'lead' while its first char is not found yet
+      ByteRange range;
+      bool lead = false;
       while (true) {
-         char c;
-         if (!is.get(c))
+         std::size_t n = std::min(is.fill(BLOCK), BLOCK);
+         if (n == 0)
             break; // EOF
-         if (!save)
-            before += c;
-         if (save)
-            content += c;
-         if (c == '{') {
-            count_par++;
-            if ((count_par == target_field + 1) && !save) // 2?
-            {
-               content += c;
-               save = true;
-            }
+         const char* block = is.current();
+         char padded[BLOCK];
+         if (n < BLOCK) {
+            // last partial block: pad with spaces
+            std::fill(padded, padded + BLOCK, ' ');
+            std::copy(block, block + n, padded);
+            block = padded;
          }
-         if (c == '}') {
-            if ((count_par == target_field + 1) && save) // 2?
-            {
-               //
-               //std::cout << "RESTART = " << sbefore << std::endl;
-               //
-               // 1-get field name
-               int keyStart = before.find('\"') + 1;
-               //std::string check_before1 = before.substr(0, keyStart);
-               //std::cout << "check_before1 = '" << check_before1 << "'" << std::endl;
-               int keyEnd = before.find('\"', keyStart + 1);
-               //std::string check_before2 = before.substr(keyEnd, before.length()-keyEnd);
-               //std::cout << "check_before2 = '" << check_before2 << "'" << std::endl;
-               //std::cout << "keyEnd = " << keyEnd << " keyStart = " << keyStart << std::endl;
-               std::string field_name = "";
-               if (keyEnd < 0) {
-                  std::cerr << "WARNING: VastJSON failed to get field (mode: BIG_ROOT_DICT_NO_ROOT_LIST)" << std::endl;
-                  this->hasError = true;
-                  before = ""; // manual remove
-               } else {
-                  int keySize = keyEnd - keyStart;
-                  field_name = before.substr(keyStart, keySize);
-                  before = "";
-                  //2-move string to cache
-                  //std::cout << "x1 field_name: " << field_name << " content->" << content << std::endl;
-                  cache[field_name] = std::move(content); // <------ IT'S FUNDAMENTAL TO std::move() HERE!
+         std::uint64_t block_pos = is.tellg();
+         std::uint64_t bits = indexer.next(block);
+         if (n < BLOCK)
+            bits &= (std::uint64_t(1) << n) - 1;
+         // first char of pending key or value on this block
+         std::size_t from = 0;
+         // first and last non-space chars of value on [first, end) of block (offsets only)
+         auto findBegin = [&](std::size_t first, std::size_t end) {
+            while (lead && (first < end)) {
+               if (!isSpace(block[first])) {
+                  range.begin = block_pos + first;
+                  lead = false;
                }
-               //
-               //std::cout << "store = '" << field_name << "'" << std::endl;
-               //
-               //before = std::stringstream();
-               //content = std::stringstream();
-               content = "";
-               //
-               save = false;
-               // if 'targetKey' is found, stop reading
-               if ((targetKey != "") && (field_name == targetKey)) {
-                  // perform count_par decrease and stop (for now)
-                  count_par--;
-                  break;
+               first++;
+            }
+         };
+         auto findEnd = [&](std::size_t first, std::size_t end) {
+            while (!lead && (end > first)) {
+               if (!isSpace(block[--end])) {
+                  range.end = std::max(range.begin, block_pos + end + 1);
+                  return;
+               }
+            }
+         };
+         if ((step == 3) && !copy)
+            findBegin(0, n);
+         for (; bits; bits &= bits - 1) {
+            std::size_t k = StructuralIndexer::trailingZeros(bits);
+            char c = block[k];
+            int depth = count_par;
+            if ((c == '{') || (c == '['))
+               count_par++;
+            else if ((c == '}') || (c == ']'))
+               count_par--;
+            if (depth == 0) {
+               if (c == '{')
+                  continue; // root is opened
+               std::cerr << "WARNING: VastJSON failed to get root dict (mode: BIG_ROOT_DICT_NO_ROOT_LIST)" << std::endl;
+               this->hasError = true;
+               is.ignore();
+               count_par = 0;
+               return;
+            }
+            if ((depth == 1) && ((c == '{') || (c == '[')) && (step != 3)) {
+               std::cerr << "WARNING: VastJSON failed to get field (mode: BIG_ROOT_DICT_NO_ROOT_LIST)" << std::endl;
+               this->hasError = true;
+            } else if ((depth == 1) && (c == '[')) {
+               // list is stored anyway (as mapped file)
+               std::cerr << "WARNING: VastJSON found list as top-level entry (mode: BIG_ROOT_DICT_NO_ROOT_LIST)" << std::endl;
+               this->hasError = true;
+            }
+            if ((depth != 1) || (c == '{') || (c == '['))
+               continue; // nothing to do inside top-level values
+            bool last = ((c == '}') || (c == ']'));
+            if ((c == '"') && (step < 2)) {
+               if (step == 1)
+                  key.append(block + from, block + k);
+               else
+                  key.clear();
+               from = k + 1;
+               step++;
+            } else if (c == ':') {
+               if (step != 2) {
+                  std::cerr << "WRONG DELIMITER! ABORT!" << std::endl;
+                  this->hasError = true;
+                  is.ignore();
+                  count_par = 0;
+                  return;
                }
-               // check if count_keys is enabled (>= 0)
-               if (count_keys >= 0) {
-                  // counting is enabled.. must decrease one key
-                  count_keys--;
-                  // check if count has been reached
-                  if (count_keys == 0) {
-                     // perform count_par decrease and stop (for now)
-                     count_par--;
-                     break;
+               from = k + 1;
+               step = 3;
+               lead = !copy;
+               findBegin(from, n);
+            } else if ((c == ',') || last) {
+               bool stored = false;
+               if (step == 3) {
+                  // top-level value ends here (with spaces trimmed, as mapped file)
+                  if (copy) {
+                     content.append(block + from, block + k);
+                     std::size_t b = 0;
+                     std::size_t e = content.length();
+                     while ((b < e) && isSpace(content[b]))
+                        b++;
+                     while ((e > b) && isSpace(content[e - 1]))
+                        e--;
+                     if (e > b) {
+                        storeCache(key, content.substr(b, e - b));
+                        stored = true;
+                     }
+                     std::string().swap(content);
+                  } else {
+                     findEnd(from, k);
+                     if (!lead && (range.end > range.begin)) {
+                        storeOffset(key, range);
+                        stored = true;
+                     }
                   }
                }
+               step = 0;
+               if (last) {
+                  // root is finished: consume rest of stream
+                  is.ignore();
+                  return;
+               }
+               // if 'targetKey' is found, or 'count_keys' keys are found (when >= 0), stop reading
+               if (stored && (((targetKey != "") && (key == targetKey)) || ((count_keys >= 0) && (--count_keys == 0)))) {
+                  is.skip(k + 1);
+                  return;
+               }
             }
-            count_par--;
          }
+         // key or value continues on next block
+         if (step == 1)
+            key.append(block + from, block + n);
+         else if ((step == 3) && copy)
+            content.append(block + from, block + n);
+         else if (step == 3)
+            findEnd(from, n);
+         is.skip(n);
       }
    }
 
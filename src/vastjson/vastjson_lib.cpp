@@ -65,6 +65,16 @@ vastjson_at_cache(void *obj, const char *targetKey, int sz_vr)
 }
 //gets string from cache
 
+const char *
+vastjson_get_raw(void *obj, const char *targetKey, int sz_vr, int *sz_out)
+{
+    vastjson::VastJSON* vobj = (vastjson::VastJSON*) obj;
+    std::string_view raw = vobj->getRaw(std::string_view(targetKey, sz_vr));
+    *sz_out = raw.length();
+    return raw.data();
+}
+//gets raw bytes (no copy)
+
 void
 vastjson_free_string_ptr(char *str)
 {
@@ -93,3 +103,77 @@ vastjson_get_until(void *obj, const char *targetKey, int sz_vr, int count_keys)
     std::string key(targetKey);
     vobj->getUntil(key, count_keys);
 }
+
+// ================
+//   work counters
+// ================
+
+static const char* vastjson_stat_names[] = {
+    "bytes_scanned", "entries_indexed", "parse_calls", "parse_bytes", "cache_hits", "cache_misses",
+    "evictions", "serializations", "scan_ns", "parse_ns", "serialize_ns",
+    "cache_bytes", "peak_cache_bytes", "json_bytes", "peak_json_bytes"
+};
+
+extern "C" void
+vastjson_enable_stats(void *obj)
+{
+    vastjson::VastJSON* vobj = (vastjson::VastJSON*) obj;
+    vobj->enableStats();
+}
+
+extern "C" void
+vastjson_reset_stats(void *obj)
+{
+    vastjson::VastJSON* vobj = (vastjson::VastJSON*) obj;
+    vobj->resetStats();
+}
+
+extern "C" int
+vastjson_get_stats(void *obj, unsigned long long *out, int n)
+{
+    vastjson::VastJSON* vobj = (vastjson::VastJSON*) obj;
+    vastjson::StatsVastJSON st = vobj->getStats();
+    const unsigned long long values[] = {
+        st.bytes_scanned, st.entries_indexed, st.parse_calls, st.parse_bytes, st.cache_hits, st.cache_misses,
+        st.evictions, st.serializations, st.scan_ns, st.parse_ns, st.serialize_ns,
+        st.cache_bytes, st.peak_cache_bytes, st.json_bytes, st.peak_json_bytes
+    };
+    int total = sizeof(values) / sizeof(values[0]);
+    for (int i = 0; (i < n) && (i < total); i++)
+        out[i] = values[i];
+    return total;
+}
+
+extern "C" const char *
+vastjson_stat_name(int i)
+{
+    int total = sizeof(vastjson_stat_names) / sizeof(vastjson_stat_names[0]);
+    return ((i >= 0) && (i < total)) ? vastjson_stat_names[i] : nullptr;
+}
+
+// ================
+//  memory usage
+// ================
+
+static const char* vastjson_memory_names[] = {
+    "cache", "packed", "json", "keys", "other", "spilled", "total"
+};
+
+extern "C" int
+vastjson_memory_usage(void *obj, const char *targetKey, int sz_vr, unsigned long long *out, int n)
+{
+    vastjson::VastJSON* vobj = (vastjson::VastJSON*) obj;
+    vastjson::MemoryVastJSON m = targetKey ? vobj->memoryUsage(std::string_view(targetKey, sz_vr)) : vobj->memoryUsage();
+    const unsigned long long values[] = { m.cache, m.packed, m.json, m.keys, m.other, m.spilled, m.total() };
+    int total = sizeof(values) / sizeof(values[0]);
+    for (int i = 0; (i < n) && (i < total); i++)
+        out[i] = values[i];
+    return total;
+}
+
+extern "C" const char *
+vastjson_memory_name(int i)
+{
+    int total = sizeof(vastjson_memory_names) / sizeof(vastjson_memory_names[0]);
+    return ((i >= 0) && (i < total)) ? vastjson_memory_names[i] : nullptr;
+}
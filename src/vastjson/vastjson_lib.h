@@ -31,6 +31,10 @@ extern "C" char *
 vastjson_at_cache(void *obj, const char *targetKey, int sz_vr);
 //gets string from cache
 
+extern "C" const char *
+vastjson_get_raw(void *obj, const char *targetKey, int sz_vr, int *sz_out);
+//gets raw bytes of top-level value (not null-terminated, size on 'sz_out'), owned by obj (do not free)
+
 extern "C" void
 vastjson_get_until(void *obj, const char *targetKey, int sz_vr, int count_keys);
 //void getUntil(std::string targetKey = "", int count_keys = -1)
@@ -47,5 +51,38 @@ extern "C" int
 vastjson_cache_size(void *obj);
 //gets size
 
+// ================
+//   work counters
+// ================
+
+extern "C" void
+vastjson_enable_stats(void *obj);
+//void enableStats()
+
+extern "C" void
+vastjson_reset_stats(void *obj);
+//void resetStats()
+
+extern "C" int
+vastjson_get_stats(void *obj, unsigned long long *out, int n);
+//fills 'out' with first 'n' counters of getStats() (in order of vastjson_stat_name), returns number of counters
+
+extern "C" const char *
+vastjson_stat_name(int i);
+//name of counter 'i' (such as "bytes_scanned"), or null
+
+// ================
+//  memory usage
+// ================
+
+extern "C" int
+vastjson_memory_usage(void *obj, const char *targetKey, int sz_vr, unsigned long long *out, int n);
+//fills 'out' with first 'n' fields of memoryUsage(key) (or memoryUsage(), if targetKey is null), in order of vastjson_memory_name
+//returns number of fields
+
+extern "C" const char *
+vastjson_memory_name(int i);
+//name of memory field 'i' (such as "cache"), or null
+
 
 #endif // VASTJSON_LIB_H
\ No newline at end of file
@@ -35,6 +35,11 @@ vastjson_lib.vastjson_at_cache.argtypes = [
     ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int] # void
 vastjson_lib.vastjson_at_cache.restype = ctypes.c_char_p
 
+#vastjson_get_raw(void *obj, const char *targetKey, int sz_vr, int *sz_out) -> const char *
+vastjson_lib.vastjson_get_raw.argtypes = [
+    ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int, ctypes.POINTER(ctypes.c_int)]
+vastjson_lib.vastjson_get_raw.restype = ctypes.c_void_p
+
 #vastjson_free_string_ptr(char *str) -> void
 vastjson_lib.vastjson_free_string_ptr.argtypes = [
     ctypes.c_char_p] # void
@@ -49,6 +54,34 @@ vastjson_lib.vastjson_cache_size.argtypes = [
     ctypes.c_void_p]
 vastjson_lib.vastjson_cache_size.restype = ctypes.c_int
 
+#vastjson_enable_stats(void *obj) -> void
+vastjson_lib.vastjson_enable_stats.argtypes = [
+    ctypes.c_void_p]
+
+#vastjson_reset_stats(void *obj) -> void
+vastjson_lib.vastjson_reset_stats.argtypes = [
+    ctypes.c_void_p]
+
+#vastjson_get_stats(void *obj, unsigned long long *out, int n) -> int
+vastjson_lib.vastjson_get_stats.argtypes = [
+    ctypes.c_void_p, ctypes.POINTER(ctypes.c_ulonglong), ctypes.c_int]
+vastjson_lib.vastjson_get_stats.restype = ctypes.c_int
+
+#vastjson_stat_name(int i) -> const char *
+vastjson_lib.vastjson_stat_name.argtypes = [
+    ctypes.c_int]
+vastjson_lib.vastjson_stat_name.restype = ctypes.c_char_p
+
+#vastjson_memory_usage(void *obj, const char *targetKey, int sz_vr, unsigned long long *out, int n) -> int
+vastjson_lib.vastjson_memory_usage.argtypes = [
+    ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int, ctypes.POINTER(ctypes.c_ulonglong), ctypes.c_int]
+vastjson_lib.vastjson_memory_usage.restype = ctypes.c_int
+
+#vastjson_memory_name(int i) -> const char *
+vastjson_lib.vastjson_memory_name.argtypes = [
+    ctypes.c_int]
+vastjson_lib.vastjson_memory_name.restype = ctypes.c_char_p
+
 
 # ===============================================================
 # VastJSON (py) is a pythonic API to VastJSON C++ implementation
@@ -90,6 +123,16 @@ class VastJSON(object):
         #vastjson_lib.vastjson_free_string_ptr(charptr)
         return local_str
     
+    def getRaw(self, param: str) -> bytes:
+        # exact original bytes of top-level value (no parsing), copied once into python
+        strsize = len(param)
+        strdata = (ctypes.c_char * strsize).from_buffer(bytearray(param, 'ascii'))
+        rawsize = ctypes.c_int(0)
+        rawptr = vastjson_lib.vastjson_get_raw(self._vjptr, strdata, strsize, ctypes.byref(rawsize))
+        if not rawptr:
+            return b""
+        return ctypes.string_at(rawptr, rawsize.value)
+
     def getUntil(self, param: str = "", count:int = -1):
         print("GET UNTIL")
         strsize = len(param)
@@ -101,3 +144,25 @@ class VastJSON(object):
 
     def cacheSize(self):
         return vastjson_lib.vastjson_cache_size(self._vjptr)
+
+    def enableStats(self):
+        vastjson_lib.vastjson_enable_stats(self._vjptr)
+
+    def resetStats(self):
+        vastjson_lib.vastjson_reset_stats(self._vjptr)
+
+    def getStats(self) -> dict:
+        # counters by name (all zero if stats are not enabled)
+        total = vastjson_lib.vastjson_get_stats(self._vjptr, None, 0)
+        values = (ctypes.c_ulonglong * total)()
+        vastjson_lib.vastjson_get_stats(self._vjptr, values, total)
+        return {vastjson_lib.vastjson_stat_name(i).decode('ascii'): values[i] for i in range(total)}
+
+    def memoryUsage(self, param: str = None) -> dict:
+        # bytes per tier, of top-level entry 'param' (or of all entries)
+        strdata = None if param is None else bytes(param, 'ascii')
+        strsize = 0 if param is None else len(param)
+        total = vastjson_lib.vastjson_memory_usage(self._vjptr, strdata, strsize, None, 0)
+        values = (ctypes.c_ulonglong * total)()
+        vastjson_lib.vastjson_memory_usage(self._vjptr, strdata, strsize, values, total)
+        return {vastjson_lib.vastjson_memory_name(i).decode('ascii'): values[i] for i in range(total)}
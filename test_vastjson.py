@@ -3,12 +3,17 @@ vjson = VastJSON("{\"B\":10}")
 
 x = vjson.atCache("B")
 print(x)
+print(vjson.getRaw("B"))
 
 print(vjson.size())
 print(vjson.cacheSize())
 
 
 vjson2 = VastJSON("tests/testdata/test2.json", 0)
+vjson2.enableStats()
 print(vjson2.cacheSize())
 print(vjson2.size())
-print(vjson2.cacheSize())
\ No newline at end of file
+print(vjson2.cacheSize())
+print(vjson2.getStats())
+print(vjson2.memoryUsage())
+print(vjson2.memoryUsage("B"))
@@ -288,4 +288,962 @@ TEST_CASE("bigj istringstream from file Mode STRICT")
     REQUIRE(bigj.cacheSize() == 3);
     // size must be three
     REQUIRE(bigj.size() == 3);
-}
\ No newline at end of file
+}
+
+TEST_CASE("bigj CACHE_OFFSET keeps only offsets")
+{
+    std::unique_ptr<std::ifstream> ifs{new std::ifstream("testdata/test_common.json")};
+    VastJSON bigj{std::move(ifs), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET};
+
+    REQUIRE(bigj.getCacheMode() == CACHE_OFFSET);
+    // key B and subkey B1 must be found
+    REQUIRE(bigj["B"]["B1"] == 10);
+    // size must be correct (stream is consumed)
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(!bigj.isPending());
+    // no strings are copied into cache
+    for(auto it = bigj.begin(); it != bigj.end(); it++)
+        REQUIRE(it->second == "");
+    // entries are re-read from stream
+    REQUIRE(bigj["A"] == 1);
+    REQUIRE(bigj["Z"] == "string");
+    // unloaded entries can be re-read from stream
+    bigj.unload("B");
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+}
+
+TEST_CASE("bigj CACHE_OFFSET BIG_ROOT_DICT_NO_ROOT_LIST")
+{
+    std::unique_ptr<std::ifstream> ifs{new std::ifstream("testdata/test2.json")};
+    VastJSON bigj{std::move(ifs), BIG_ROOT_DICT_NO_ROOT_LIST, CACHE_OFFSET};
+
+    bigj.getUntil("", 1);
+    REQUIRE(bigj.cacheSize() == 1);
+    REQUIRE(bigj.atCache("A") == "");
+    // re-read while stream is still pending
+    REQUIRE(bigj["A"].size() == 0);
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(bigj["Z"].size() == 0);
+}
+
+
+TEST_CASE("bigj MappedFile zero-copy")
+{
+    VastJSON bigj{MappedFile("testdata/test_quotes.json")};
+
+    REQUIRE(bigj.getCacheMode() == CACHE_OFFSET);
+    REQUIRE(bigj.isPending());
+    // get one element
+    bigj.getUntil("", 1);
+    REQUIRE(bigj.cacheSize() == 1);
+    REQUIRE(bigj.isPending());
+    // key B and subkey B2 must be found
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    REQUIRE(bigj.cacheSize() == 2);
+    // size must be correct (mapping is consumed)
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(!bigj.isPending());
+    REQUIRE(bigj["Z"].size() == 0);
+    REQUIRE(!bigj.hasError);
+}
+
+TEST_CASE("bigj MappedFile with list and primitives")
+{
+    VastJSON bigj{MappedFile("testdata/test_with_list.json")};
+    REQUIRE(bigj.size() == 4);
+    REQUIRE(bigj["A"].size() == 2);
+    REQUIRE(bigj["A"][1]["A2"] == 2);
+
+    VastJSON bigj2{MappedFile("testdata/test_common.json"), BIG_ROOT_DICT_NO_ROOT_LIST};
+    REQUIRE(bigj2.size() == 3);
+    REQUIRE(bigj2["A"] == 1);
+    REQUIRE(bigj2["Z"] == "string");
+
+    VastJSON bigj3{MappedFile("testdata/test_common.json"), BIG_STRICT};
+    REQUIRE(!bigj3.isPending());
+    REQUIRE(bigj3.size() == 3);
+    REQUIRE(bigj3["B"]["B1"] == 10);
+
+    VastJSON bigj4{MappedFile("testdata/does_not_exist.json")};
+    REQUIRE(bigj4.hasError);
+    REQUIRE(bigj4.size() == 0);
+}
+
+
+TEST_CASE("StructuralIndexer escapes and strings")
+{
+    // block of 64 chars: quotes and escapes at known positions
+    std::string block = "{\"a\\\\\":\"x\\\"}\",\"b\":[1,{}]}";
+    block.resize(StructuralIndexer::BLOCK_SIZE, ' ');
+    StructuralIndexer indexer;
+    std::uint64_t bits = indexer.next(block.data());
+    std::string found;
+    while (bits) {
+        found += block[StructuralIndexer::trailingZeros(bits)];
+        bits &= bits - 1;
+    }
+    // escaped quote and brace inside string are ignored
+    REQUIRE(found == "{\"\":\"\",\"\":[,{}]}");
+}
+
+TEST_CASE("bigj MappedFile structural scan over strings")
+{
+    VastJSON bigj{MappedFile("testdata/test_strings.json")};
+    REQUIRE(bigj.size() == 6);
+    REQUIRE(!bigj.hasError);
+    // keys are kept escaped (as on generic mode)
+    REQUIRE(bigj.atCache("A{\\\"}") == "");
+    REQUIRE(bigj["B\\\\"]["B2"][2]["x"] == "}");
+    REQUIRE(bigj["C"] == "\\\\");
+    REQUIRE(bigj["D"] == -12500.0);
+    REQUIRE(bigj["E"][0].get<std::string>().length() > 64);
+    REQUIRE(bigj["Z"]["last"] == true);
+
+    // same result as generic mode over stream
+    VastJSON bigj2{new std::ifstream("testdata/test_strings.json")};
+    REQUIRE(bigj2.size() == 6);
+    REQUIRE(bigj2["B\\\\"] == bigj["B\\\\"]);
+}
+
+TEST_CASE("bigj BIG_ROOT_DICT_NO_ROOT_LIST structural scan over stream strings")
+{
+    VastJSON bigj{MappedFile("testdata/test_strings.json"), BIG_ROOT_DICT_NO_ROOT_LIST};
+    REQUIRE(bigj.size() == 6);
+    for (CacheVastJSON cacheMode : {CACHE_STRING, CACHE_OFFSET}) {
+        VastJSON bigj2{new std::ifstream("testdata/test_strings.json"), BIG_ROOT_DICT_NO_ROOT_LIST, cacheMode};
+        // lazy: stops right after first entry (outside strings), and resumes from there
+        REQUIRE(bigj2["A{\\\"}"] == "value with { [ , : and \"quoted\" } ] braces");
+        REQUIRE(bigj2.cacheSize() == 1);
+        REQUIRE(bigj2.size() == 6);
+        // "E" is a list (not allowed as top-level entry, but still indexed)
+        REQUIRE(bigj2.hasError);
+        REQUIRE(bigj.hasError);
+        // same keys and values as mapped file (values have no surrounding spaces)
+        for (auto it = bigj.begin(); it != bigj.end(); it++) {
+            REQUIRE(bigj2.getRaw(it->first) == bigj.getRaw(it->first));
+            REQUIRE(bigj2[it->first] == bigj[it->first]);
+        }
+    }
+}
+
+
+TEST_CASE("bigj MappedFile indexParallel")
+{
+    VastJSON bigj{MappedFile("testdata/test_strings.json")};
+    VastJSON bigj2{MappedFile("testdata/test_strings.json")};
+    bigj2.size();
+    // tiny chunks: boundaries fall inside strings, escapes and values
+    for (std::size_t chunk : {1, 7, 13, 64, 1000}) {
+        VastJSON bigj3{MappedFile("testdata/test_strings.json")};
+        bigj3.indexParallel(4, chunk);
+        REQUIRE(!bigj3.isPending());
+        REQUIRE(bigj3.size() == 6);
+        for (auto it = bigj2.begin(); it != bigj2.end(); it++)
+            REQUIRE(bigj3[it->first] == bigj2[it->first]);
+    }
+    // parallel indexing after partial consumption continues sequentially
+    bigj.getUntil("", 1);
+    bigj.indexParallel();
+    REQUIRE(bigj.cacheSize() == 6);
+}
+
+
+TEST_CASE("bigj sidecar index file")
+{
+    std::remove("testdata/test_strings.json.vjidx");
+    VastJSON bigj{MappedFile("testdata/test_strings.json")};
+    // no sidecar yet
+    REQUIRE(!bigj.loadIndex());
+    REQUIRE(bigj.saveIndex());
+
+    // reopen: index is loaded without scanning json
+    VastJSON bigj2{MappedFile("testdata/test_strings.json")};
+    REQUIRE(bigj2.useIndex());
+    REQUIRE(!bigj2.isPending());
+    REQUIRE(bigj2.cacheSize() == 6);
+    REQUIRE(bigj2["B\\\\"] == bigj["B\\\\"]);
+    REQUIRE(bigj2["Z"]["last"] == true);
+
+    // sidecar does not match another file
+    VastJSON bigj3{MappedFile("testdata/test2.json")};
+    REQUIRE(!bigj3.loadIndex("testdata/test_strings.json.vjidx"));
+    REQUIRE(bigj3.isPending());
+    REQUIRE(bigj3.size() == 3);
+    std::remove("testdata/test_strings.json.vjidx");
+}
+
+
+TEST_CASE("bigj BIG_ROOT_LIST over stream")
+{
+    VastJSON bigj{new std::ifstream("testdata/test_list.json"), BIG_ROOT_LIST};
+    REQUIRE(bigj.getMode() == BIG_ROOT_LIST);
+    // lazy access by position
+    REQUIRE(bigj[1].size() == 2);
+    REQUIRE(bigj.cacheSize() == 2);
+    REQUIRE(bigj.isPending());
+    bigj.getUntil("", 1);
+    REQUIRE(bigj.cacheSize() == 3);
+    REQUIRE(bigj[2] == "str, ] with \"quotes\"");
+    REQUIRE(bigj.size() == 6);
+    REQUIRE(!bigj.isPending());
+    REQUIRE(bigj[4]["B"]["C"].size() == 0);
+    REQUIRE(!bigj.contains("6"));
+
+    // lazy forward iteration (in position order)
+    VastJSON bigj2{new std::ifstream("testdata/test_list.json"), BIG_ROOT_LIST, CACHE_OFFSET};
+    std::vector<nlohmann::json> elems;
+    for (auto it = bigj2.beginList(); it != bigj2.endList(); ++it) {
+        REQUIRE(it.position() == elems.size());
+        elems.push_back(*it);
+        bigj2.unload(std::to_string(it.position()));
+    }
+    REQUIRE(elems.size() == 6);
+    REQUIRE(elems[0]["A"] == 1);
+    REQUIRE(elems[3] == 10);
+    REQUIRE(elems[5] == -150.0);
+    REQUIRE(!bigj2.hasError);
+
+    std::string empty = "[ ]";
+    VastJSON bigj3{std::unique_ptr<std::istream>{new std::istringstream(empty)}, BIG_ROOT_LIST};
+    REQUIRE(bigj3.size() == 0);
+
+    // begin() also follows positions (not string order "0", "1", "10", "11", "2", ...)
+    VastJSON bigj4{new std::istringstream("[0,1,2,3,4,5,6,7,8,9,10,11]"), BIG_ROOT_LIST};
+    std::size_t pos = 0;
+    for (auto it = bigj4.begin(); it != bigj4.end(); it++, pos++) {
+        REQUIRE(it->first == std::to_string(pos));
+        REQUIRE(bigj4[it->first] == pos);
+    }
+    REQUIRE(pos == 12);
+}
+
+TEST_CASE("bigj BIG_ROOT_LIST over mapped file")
+{
+    VastJSON bigj{new std::ifstream("testdata/test_list.json"), BIG_ROOT_LIST};
+    VastJSON bigj2{MappedFile("testdata/test_list.json"), BIG_ROOT_LIST};
+    REQUIRE(bigj2[3] == 10);
+    REQUIRE(bigj2.cacheSize() == 4);
+    REQUIRE(bigj2.size() == 6);
+    for (std::size_t chunk : {1, 5, 64}) {
+        VastJSON bigj3{MappedFile("testdata/test_list.json"), BIG_ROOT_LIST};
+        bigj3.indexParallel(3, chunk);
+        REQUIRE(bigj3.size() == 6);
+        for (std::size_t i = 0; i < bigj.size(); i++) {
+            REQUIRE(bigj3[i] == bigj[i]);
+            REQUIRE(bigj2[i] == bigj[i]);
+        }
+    }
+}
+
+
+TEST_CASE("bigj BIG_TARGET_ELEMENT")
+{
+    VastJSON bigj{new std::ifstream("testdata/test_target.json"), nlohmann::json::json_pointer("/results/1/items")};
+    REQUIRE(bigj.getMode() == BIG_TARGET_ELEMENT);
+    // children of target are the top-level entries
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    REQUIRE(bigj.cacheSize() == 2);
+    // siblings before target are already parsed
+    REQUIRE(bigj.getOuter()["meta"]["name"] == "x/y");
+    REQUIRE(bigj.getOuter()["results"][0]["skip"] == true);
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(!bigj.isPending());
+    REQUIRE(bigj["C"][1] == 2);
+    // siblings after target are parsed once target is indexed
+    nlohmann::json outer = nlohmann::json::parse(
+      "{\"meta\": {\"version\": 2, \"name\": \"x/y\"}, \"results\": [{\"skip\": true}, {\"items\": null, \"count\": 3}, 7], \"after\": \"done\"}");
+    REQUIRE(bigj.getOuter() == outer);
+    REQUIRE(!bigj.hasError);
+
+    VastJSON bigj2{std::unique_ptr<std::istream>{new std::ifstream("testdata/test_target.json")}, nlohmann::json::json_pointer("/meta"), CACHE_OFFSET};
+    REQUIRE(bigj2.size() == 2);
+    REQUIRE(bigj2["name"] == "x/y");
+    REQUIRE(bigj2.getOuter()["after"] == "done");
+
+    VastJSON bigj3{new std::ifstream("testdata/test_target.json"), nlohmann::json::json_pointer("/missing")};
+    REQUIRE(bigj3.size() == 0);
+    REQUIRE(bigj3.hasError);
+
+    // corrupt sibling is null on outer json, flagging error
+    VastJSON bigj4{new std::istringstream("{\"meta\": tru, \"data\": {\"A\": 1}}"), nlohmann::json::json_pointer("/data")};
+    REQUIRE(bigj4["A"] == 1);
+    REQUIRE(bigj4.getOuter()["meta"].is_null());
+    REQUIRE(bigj4.hasError);
+    // also for root primitives
+    std::string bad = "tru";
+    VastJSON bigj5{bad};
+    REQUIRE(bigj5.hasError);
+
+    // list target is indexed lazily by position (as BIG_ROOT_LIST)
+    std::stringstream ss;
+    ss << "{\"meta\": {\"n\": 12}, \"results\": {\"items\": [";
+    for (int i = 0; i < 12; i++)
+        ss << (i ? ", " : "") << "{\"id\": " << i << "}";
+    ss << "], \"count\": 12}, \"after\": [1, 2]}";
+    for (CacheVastJSON cacheMode : { CACHE_STRING, CACHE_OFFSET }) {
+        VastJSON bigj6{std::unique_ptr<std::istream>{new std::istringstream(ss.str())}, nlohmann::json::json_pointer("/results/items"), cacheMode};
+        REQUIRE(bigj6[1]["id"] == 1);
+        REQUIRE(bigj6.cacheSize() == 2);
+        REQUIRE(bigj6.isPending());
+        std::size_t n = 0;
+        for (auto it = bigj6.beginList(); it != bigj6.endList(); ++it)
+            REQUIRE((*it)["id"] == int(n++));
+        REQUIRE(n == 12);
+        REQUIRE(bigj6.size() == 12);
+        // keys are in list order
+        REQUIRE(bigj6.begin()->first == "0");
+        REQUIRE(std::prev(bigj6.end())->first == "11");
+        REQUIRE(bigj6.getOuter()["results"]["count"] == 12);
+        REQUIRE(bigj6.getOuter()["after"][1] == 2);
+        REQUIRE(bigj6.getOuter()["results"]["items"].is_null());
+        REQUIRE(!bigj6.hasError);
+    }
+}
+
+TEST_CASE("bigj getUntil last key")
+{
+    VastJSON bigj{new std::ifstream("testdata/test2.json")};
+    bigj.getUntil("Z");
+    // resuming on final '}' must not create extra entries
+    REQUIRE(bigj.size() == 3);
+}
+
+
+TEST_CASE("bigj BIG_JSON_LINES")
+{
+    VastJSON bigj{new std::ifstream("testdata/test_lines.jsonl"), BIG_JSON_LINES};
+    REQUIRE(bigj.getMode() == BIG_JSON_LINES);
+    REQUIRE(bigj[1].size() == 3);
+    REQUIRE(bigj.cacheSize() == 2);
+    // empty lines are skipped
+    REQUIRE(bigj[2] == "third");
+    REQUIRE(bigj.size() == 5);
+    REQUIRE(bigj[3] == 42);
+    REQUIRE(bigj[4]["id"] == 4);
+    // same lifecycle of other modes
+    REQUIRE(bigj[0]["id"] == 0);
+    bigj.toCache("0");
+    REQUIRE(bigj.atCache("0") != "");
+    REQUIRE(bigj[0]["s"] == "a\nb");
+
+    VastJSON bigj2{new std::ifstream("testdata/test_lines.jsonl"), BIG_JSON_LINES, CACHE_OFFSET};
+    VastJSON bigj3{MappedFile("testdata/test_lines.jsonl"), BIG_JSON_LINES};
+    bigj3.getUntil("", 3);
+    REQUIRE(bigj3.cacheSize() == 3);
+    REQUIRE(bigj3.isPending());
+    std::size_t count = 0;
+    for (auto it = bigj2.beginList(); it != bigj2.endList(); ++it, count++) {
+        REQUIRE(*it == bigj[it.position()]);
+        REQUIRE(bigj3[it.position()] == bigj[it.position()]);
+    }
+    REQUIRE(count == 5);
+    for (std::size_t chunk : {1, 7, 64}) {
+        VastJSON bigj4{MappedFile("testdata/test_lines.jsonl"), BIG_JSON_LINES};
+        bigj4.indexParallel(2, chunk);
+        REQUIRE(bigj4.size() == 5);
+        for (std::size_t i = 0; i < 5; i++)
+            REQUIRE(bigj4[i] == bigj[i]);
+    }
+}
+
+TEST_CASE("bigj flat hash index")
+{
+    VastJSON bigj{new std::ifstream("testdata/test2.json")};
+    bigj.enableFlatIndex();
+    REQUIRE(bigj.hasFlatIndex());
+    std::string_view key = "B";
+    REQUIRE(bigj[key]["B1"] == 10);
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    // unload/toCache keep index consistent
+    bigj.toCache("B");
+    REQUIRE(bigj.atCache("B") != "");
+    REQUIRE(bigj["B"]["B1"] == 10);
+    bigj.unload("Z");
+    REQUIRE(bigj.size() == 3);
+
+    // enabled after loading (offsets from mapped file)
+    VastJSON bigj2{MappedFile("testdata/test_strings.json")};
+    bigj2.getUntil("");
+    bigj2.enableFlatIndex();
+    REQUIRE(bigj2["Z"]["last"] == true);
+    REQUIRE(bigj2["Z"]["last"] == true);
+    VastJSON bigj3{std::move(bigj2)};
+    REQUIRE(bigj3.hasFlatIndex());
+    REQUIRE(bigj3["Z"]["last"] == true);
+    // byte ranges are served from index (also after unload, and edits kept by toCache)
+    bigj3.unload("Z");
+    REQUIRE(bigj3["Z"]["last"] == true);
+    bigj3["Z"]["last"] = false;
+    bigj3.toCache("Z");
+    REQUIRE(bigj3.getRaw("Z") == "{\"last\":false}");
+    REQUIRE(bigj3["Z"]["last"] == false);
+    REQUIRE(bigj3.contains("D"));
+    REQUIRE(!bigj3.contains("Y"));
+
+    // index over ranges loaded from sidecar file
+    VastJSON bigj4{MappedFile("testdata/test_strings.json")};
+    REQUIRE(bigj4.saveIndex("build/flat_index.vjidx"));
+    VastJSON bigj5{MappedFile("testdata/test_strings.json")};
+    bigj5.enableFlatIndex();
+    REQUIRE(bigj5.loadIndex("build/flat_index.vjidx"));
+    REQUIRE(bigj5["B\\\\"]["B2"][2]["x"] == "}");
+    REQUIRE(bigj5["D"] == -12500.0);
+    std::remove("build/flat_index.vjidx");
+}
+
+TEST_CASE("bigj memory budget")
+{
+    VastJSON bigj{new std::ifstream("testdata/test2.json")};
+    REQUIRE(bigj["B"]["B1"] == 10);
+    bigj.setMemoryBudget(1);
+    REQUIRE(bigj.getMemoryBudget() == 1);
+    // most recent entry is always kept
+    REQUIRE(bigj.parsedBytes() > 0);
+    REQUIRE(bigj.atCache("B") == "");
+    REQUIRE(bigj["A"].size() == 0);
+    // 'B' demoted to string cache
+    REQUIRE(bigj.atCache("B") != "");
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    REQUIRE(bigj.atCache("B") == "");
+    REQUIRE(bigj.atCache("A") != "");
+
+    // offset entries are simply dropped
+    VastJSON bigj2{MappedFile("testdata/test_strings.json")};
+    bigj2.setMemoryBudget(1024 * 1024);
+    REQUIRE(bigj2["Z"]["last"] == true);
+    std::size_t one = bigj2.parsedBytes();
+    REQUIRE(bigj2["E"].size() == 1);
+    REQUIRE(bigj2.parsedBytes() > one);
+    bigj2.setMemoryBudget(one);
+    REQUIRE(bigj2.parsedBytes() < 2 * one);
+    REQUIRE(bigj2.atCache("Z") == "");
+    REQUIRE(bigj2["Z"]["last"] == true);
+    bigj2.setMemoryBudget(0);
+    REQUIRE(bigj2.parsedBytes() == 0);
+}
+
+TEST_CASE("bigj BIG_ROOT_DICT_GENERIC value boundaries")
+{
+    // numbers are delimited by lookahead char (put back on stream)
+    VastJSON bigj{new std::istringstream("{\"a\":1,\"b\": -2.5e1 ,\"c\":[3],\"d\":true,\"e\":4}")};
+    REQUIRE(bigj.size() == 5);
+    REQUIRE(bigj["a"] == 1);
+    REQUIRE(bigj["b"] == -25.0);
+    REQUIRE(bigj["c"][0] == 3);
+    REQUIRE(bigj["d"] == true);
+    REQUIRE(bigj["e"] == 4);
+    REQUIRE(!bigj.hasError);
+    // root primitive up to end of stream
+    VastJSON bigj2{new std::istringstream("42")};
+    REQUIRE(bigj2[""] == 42);
+}
+
+TEST_CASE("bigj skip-only indexing keeps raw entries")
+{
+    // values are not re-serialized while indexing
+    VastJSON bigj{new std::istringstream("{\"A\": [1, 2.0e3] ,\"B\":{\"x\":\"}\\\"]\"},\"C\":-0.5}")};
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(bigj.atCache("A") == "[1, 2.0e3]");
+    REQUIRE(bigj.atCache("B") == "{\"x\":\"}\\\"]\"}");
+    REQUIRE(bigj.atCache("C") == "-0.5");
+    REQUIRE(bigj["B"]["x"] == "}\"]");
+    REQUIRE(!bigj.hasError);
+    // bad syntax is reported
+    VastJSON bigj2{new std::istringstream("{\"A\":[1,],\"B\":2}")};
+    bigj2.size();
+    REQUIRE(bigj2.hasError);
+    VastJSON bigj3{new std::istringstream("[01,2]"), BIG_ROOT_LIST};
+    bigj3.size();
+    REQUIRE(bigj3.hasError);
+}
+
+TEST_CASE("bigj getRaw")
+{
+    VastJSON bigj{new std::istringstream("{\"A\": [1, 2] ,\"B\":{\"x\":1}}")};
+    REQUIRE(bigj.getRaw("A") == "[1, 2]");
+    REQUIRE(bigj.getRaw("Z") == "");
+    // parsed entries are dumped
+    REQUIRE(bigj["B"]["x"] == 1);
+    REQUIRE(bigj.getRaw("B") == "{\"x\":1}");
+    // offsets are re-read from stream
+    VastJSON bigj2(new std::ifstream("testdata/test2.json"), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET);
+    REQUIRE(nlohmann::json::parse(bigj2.getRaw("B")) == bigj2["B"]);
+    // zero-copy slices of mapped file
+    VastJSON bigj3(MappedFile("testdata/test2.json"));
+    REQUIRE(nlohmann::json::parse(bigj3.getRaw("B")) == bigj3["B"]);
+}
+
+TEST_CASE("bigj background prefetch")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 1000; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"v\":" << i << "}";
+    ss << "}";
+    VastJSON bigj{new std::istringstream(ss.str())};
+    bigj.startPrefetch(16);
+    REQUIRE(bigj.isPrefetching());
+    REQUIRE(bigj["k3"]["v"] == 3);
+    REQUIRE(bigj.waitKey("k999"));
+    REQUIRE(!bigj.waitKey("missing"));
+    REQUIRE(bigj["k999"]["v"] == 999);
+    REQUIRE(bigj.size() == 1000);
+    bigj.stopPrefetch();
+    REQUIRE(!bigj.isPrefetching());
+    // stopped early (remaining keys are indexed on demand)
+    VastJSON bigj2{new std::istringstream(ss.str())};
+    bigj2.startPrefetch(1);
+    bigj2.stopPrefetch();
+    REQUIRE(bigj2["k500"]["v"] == 500);
+    REQUIRE(bigj2.size() == 1000);
+
+    // whole-index operations stop worker first (others are serialized with it)
+    VastJSON bigj3{MappedFile("testdata/test_strings.json")};
+    bigj3.startPrefetch(1);
+    bigj3.enableFlatIndex();
+    bigj3.setMemoryBudget(1024);
+    REQUIRE(bigj3.cacheSize() <= 6);
+    bigj3.indexParallel(4, 13);
+    REQUIRE(!bigj3.isPrefetching());
+    REQUIRE(bigj3.size() == 6);
+    REQUIRE(bigj3.saveIndex("build/prefetch.vjidx"));
+    VastJSON bigj4{MappedFile("testdata/test_strings.json")};
+    bigj4.startPrefetch(1);
+    REQUIRE(bigj4.loadIndex("build/prefetch.vjidx"));
+    REQUIRE(!bigj4.isPrefetching());
+    REQUIRE(bigj4["Z"]["last"] == true);
+    std::remove("build/prefetch.vjidx");
+}
+
+TEST_CASE("bigj concurrent reads")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 200; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"v\":" << i << "}";
+    ss << "}";
+    VastJSON bigj{new std::istringstream(ss.str())};
+    REQUIRE(bigj["k0"]["v"] == 0); // parsed before concurrent mode
+    bigj.enableConcurrentReads();
+    REQUIRE(bigj.isConcurrent());
+    std::atomic<int> errors{ 0 };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+        readers.emplace_back([&bigj, &errors]() {
+            const VastJSON& cbigj = bigj;
+            for (int i = 0; i < 200; i++)
+                if (cbigj["k" + std::to_string(i)]["v"] != i)
+                    errors++;
+        });
+    for (auto& r : readers)
+        r.join();
+    REQUIRE(errors == 0);
+    REQUIRE(bigj.size() == 200);
+    REQUIRE_THROWS_AS(bigj["missing"], std::out_of_range);
+    // mutating methods leave concurrent mode (parsed entries are kept)
+    bigj.unload("k1");
+    REQUIRE(!bigj.isConcurrent());
+    REQUIRE(bigj.atCache("k2") == "");
+    REQUIRE(bigj["k2"]["v"] == 2);
+    // offsets are re-read from stream
+    VastJSON bigj2(new std::ifstream("testdata/test2.json"), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET);
+    bigj2.enableConcurrentReads();
+    std::thread other([&bigj2]() { bigj2["B"]; });
+    bigj2["A"];
+    other.join();
+    REQUIRE(bigj2["B"] == bigj2["B"]);
+
+    // memory budget is suspended on concurrent mode, and enforced again when it's left
+    VastJSON bigj3{new std::istringstream(ss.str())};
+    bigj3.setMemoryBudget(1024 * 1024);
+    REQUIRE(bigj3["k0"]["v"] == 0);
+    std::size_t one = bigj3.parsedBytes();
+    bigj3.enableConcurrentReads();
+    REQUIRE(bigj3.getMemoryBudget() == 1024 * 1024);
+    for (int i = 0; i < 10; i++)
+        REQUIRE(bigj3["k" + std::to_string(i)]["v"] == i);
+    bigj3.disableConcurrentReads();
+    REQUIRE(bigj3.getMemoryBudget() == 1024 * 1024);
+    REQUIRE(bigj3.parsedBytes() == 10 * one);
+    bigj3.setMemoryBudget(3 * one);
+    REQUIRE(bigj3.parsedBytes() == 3 * one);
+}
+
+TEST_CASE("bigj parallel getKeys")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 100; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"v\":" << i << "}";
+    ss << "}";
+    VastJSON bigj{new std::istringstream(ss.str())};
+    REQUIRE(bigj["k1"]["v"] == 1);
+    std::vector<nlohmann::json*> out = bigj.getKeys({ "k50", "k1", "missing", "k50", "k99" }, 4);
+    REQUIRE(out.size() == 5);
+    REQUIRE((*out[0])["v"] == 50);
+    REQUIRE((*out[1])["v"] == 1);
+    REQUIRE(out[2] == nullptr);
+    REQUIRE(out[3] == out[0]);
+    REQUIRE((*out[4])["v"] == 99);
+    REQUIRE(bigj.atCache("k50") == "");
+    // predicate and callback (in key order)
+    int count = 0;
+    std::string last;
+    bigj.getKeys([](const std::string& key) { return key.length() == 2; },
+                 [&](const std::string& key, nlohmann::json& j) {
+                     REQUIRE(j["v"] == std::stoi(key.substr(1)));
+                     REQUIRE(last < key);
+                     last = key;
+                     count++;
+                 });
+    REQUIRE(count == 10);
+    // mapped file (zero-copy)
+    VastJSON bigj2(MappedFile("testdata/test2.json"));
+    out = bigj2.getKeys({ "A", "B" }, 2);
+    REQUIRE(*out[1] == bigj2["B"]);
+    REQUIRE(!bigj2.hasError);
+    // bad entry on concurrent mode is null (with no exception on worker threads)
+    VastJSON bigj3{new std::istringstream("{\"A\": {\"x\": 1}, \"B\": {\"x\": tru}, \"C\": {\"x\": 3}}"), BIG_ROOT_DICT_NO_ROOT_LIST};
+    bigj3.enableConcurrentReads();
+    out = bigj3.getKeys({ "A", "B", "C" }, 3);
+    REQUIRE((*out[0])["x"] == 1);
+    REQUIRE(out[1] == nullptr);
+    REQUIRE((*out[2])["x"] == 3);
+    REQUIRE(bigj3.hasError);
+    REQUIRE_THROWS(bigj3["B"]);
+}
+
+TEST_CASE("bigj parallel eager load")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 100; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"v\":[" << i << "]}";
+    ss << "}";
+    std::string str = ss.str();
+    VastJSON bigj{str, BIG_STRICT};
+    REQUIRE(str == "");
+    REQUIRE(bigj.size() == 100);
+    REQUIRE(bigj.atCache("k7") == "");
+    REQUIRE(bigj["k7"]["v"][0] == 7);
+    REQUIRE(!bigj.hasError);
+    // any mode, with bad entries kept on cache
+    VastJSON bigj2{new std::istringstream("{\"A\":1,\"B\":\"x\",\"C\":[true]}")};
+    bigj2.size();
+    bigj2.atCache("B") = "{bad";
+    bigj2.loadAll(2);
+    REQUIRE(bigj2.hasError);
+    REQUIRE(bigj2.atCache("A") == "");
+    REQUIRE(bigj2.atCache("B") == "{bad");
+    REQUIRE(bigj2["C"][0] == true);
+    // offsets on stream
+    VastJSON bigj3(new std::ifstream("testdata/test_common.json"), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET);
+    bigj3.loadAll(4);
+    REQUIRE(bigj3["B"]["B1"] == 10);
+    REQUIRE(!bigj3.hasError);
+}
+
+TEST_CASE("bigj BIG_STRICT throws on bad syntax")
+{
+    const char* bad[] = { "{\"A\": 1 xyz \"B\": 2 }", "{\"A\":1,\"B\":2} trailing", "{\"A\": 1, \"B\": tru }",
+                          "{\"A\":1,}", "[1, 2]", "{\"A\":1" };
+    for (const char* text : bad) {
+        std::string str = text;
+        REQUIRE_THROWS_AS((VastJSON{ str, BIG_STRICT }), nlohmann::json::parse_error);
+        REQUIRE_THROWS_AS((VastJSON{ new std::istringstream(text), BIG_STRICT }), nlohmann::json::parse_error);
+        {
+            std::ofstream out("build/strict_bad.json");
+            out << text;
+        }
+        REQUIRE_THROWS_AS((VastJSON{ MappedFile("build/strict_bad.json"), BIG_STRICT }), nlohmann::json::parse_error);
+    }
+    // whitespace around root and between entries is fine
+    std::string str = " \n{ \"A\" : 1 ,\n\"B\":{\"x\":true} , \"C\" : [ ] }\n\t";
+    VastJSON bigj{ str, BIG_STRICT };
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(bigj["B"]["x"] == true);
+    REQUIRE(!bigj.hasError);
+    {
+        std::ofstream out("build/strict_good.json");
+        out << " \n{ \"A\" : 1 ,\n\"B\":{\"x\":true} , \"C\" : [ ] }\n\t";
+    }
+    VastJSON bigj2{ MappedFile("build/strict_good.json"), BIG_STRICT };
+    REQUIRE(bigj2.size() == 3);
+    REQUIRE(bigj2["A"] == 1);
+    REQUIRE(bigj2["C"].empty());
+    std::string empty = "{ }";
+    VastJSON bigj3{ empty, BIG_STRICT };
+    REQUIRE(bigj3.size() == 0);
+    // keys are unescaped (as on a full parse)
+    const char* escaped = "{\"a\\\"b\":1,\"x\\\\y\":3,\"\\u00e9t\\u00e9\":{\"k\":2}}";
+    std::string str4 = escaped;
+    VastJSON bigj4{ str4, BIG_STRICT };
+    {
+        std::ofstream out("build/strict_escaped.json");
+        out << escaped;
+    }
+    VastJSON bigj5{ MappedFile("build/strict_escaped.json"), BIG_STRICT };
+    for (VastJSON* v : { &bigj4, &bigj5 }) {
+        REQUIRE(v->size() == 3);
+        REQUIRE((*v)["a\"b"] == 1);
+        REQUIRE((*v)["x\\y"] == 3);
+        REQUIRE((*v)["\xc3\xa9t\xc3\xa9"]["k"] == 2);
+        REQUIRE(!v->hasError);
+    }
+}
+
+TEST_CASE("BlockReader refills on block boundaries")
+{
+    std::istringstream is("ab\ncdef\n\ngh");
+    BlockReader r(&is, 3);
+    REQUIRE(r.get() == 'a');
+    REQUIRE(r.peek() == 'b');
+    REQUIRE(r.tellg() == 1);
+    std::string line;
+    REQUIRE(r.getline(line));
+    REQUIRE(line == "b");
+    REQUIRE(r.getline(line));
+    REQUIRE(line == "cdef");
+    REQUIRE(r.tellg() == 8);
+    REQUIRE(r.getline(line));
+    REQUIRE(line == "");
+    char c;
+    REQUIRE(r.get(c));
+    r.unget();
+    REQUIRE(r.get() == 'g');
+    REQUIRE(!r.eof());
+    REQUIRE(r.get() == 'h');
+    REQUIRE(r.get() == EOF);
+    REQUIRE(r.eof());
+    // chars read ahead are given back to seekable streams
+    std::istringstream is2("{\"A\":1,\"B\":2}tail");
+    BlockReader r2(&is2);
+    REQUIRE(r2.get() == '{');
+    r2.release();
+    REQUIRE(is2.get() == '\"');
+}
+
+#ifdef VASTJSON_WITH_ZLIB
+TEST_CASE("bigj gzip compressed input")
+{
+    VastJSON bigj{openFile("testdata/test_common.json.gz")};
+    REQUIRE(bigj["B"]["B1"] == 10);
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(bigj["Z"] == "string");
+    // offsets are seeked on decompressed stream
+    VastJSON bigj2{openFile("testdata/test_common.json.gz"), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET};
+    REQUIRE(bigj2.size() == 3);
+    REQUIRE(bigj2["B"]["B2"] == "abcd");
+    REQUIRE(bigj2["A"] == 1);
+    REQUIRE(!bigj2.hasError);
+}
+#endif
+
+#ifdef VASTJSON_WITH_ZSTD
+TEST_CASE("bigj zstd seekable input")
+{
+    // one frame per entry, plus seek table (skippable frame)
+    std::vector<std::string> parts = { "{\"A\":[1,2,3],", "\"B\":{\"B1\":10},", "\"Z\":\"string\"}" };
+    std::string file;
+    std::string table;
+    auto le32 = [](std::string& s, std::uint32_t v) {
+        for (int i = 0; i < 4; i++)
+            s += char((v >> (8 * i)) & 0xFF);
+    };
+    for (auto& p : parts) {
+        std::string frame(ZSTD_compressBound(p.length()), '\0');
+        frame.resize(ZSTD_compress(&frame[0], frame.length(), p.data(), p.length(), 1));
+        file += frame;
+        le32(table, frame.length());
+        le32(table, p.length());
+    }
+    le32(table, parts.size());
+    table += char(0);
+    le32(table, 0x8F92EAB1);
+    le32(file, 0x184D2A5E);
+    le32(file, table.length());
+    file += table;
+    {
+        std::ofstream ofs("build/test_seekable.json.zst", std::ios::binary);
+        ofs << file;
+    }
+    ZstdStreamBuf zbuf("build/test_seekable.json.zst");
+    REQUIRE(zbuf.seekableFrames() == 3);
+    VastJSON bigj{openFile("build/test_seekable.json.zst"), BIG_ROOT_DICT_GENERIC, CACHE_OFFSET};
+    REQUIRE(bigj.size() == 3);
+    REQUIRE(bigj["B"]["B1"] == 10);
+    REQUIRE(bigj["A"][2] == 3);
+    REQUIRE(bigj["Z"] == "string");
+    REQUIRE(!bigj.hasError);
+}
+#endif
+
+#if defined(VASTJSON_WITH_ZSTD) || defined(VASTJSON_WITH_ZLIB)
+TEST_CASE("bigj compressed string cache")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 200; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"name\":\"entry number " << i << "\",\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"text\":\"" << std::string(200, 'x') << "\",\"v\":" << i << "}";
+    ss << "}";
+    VastJSON bigj{new std::istringstream(ss.str())};
+    bigj.getUntil("k99");
+    std::size_t raw_bytes = 0;
+    for (auto it = bigj.beginCache(); it != bigj.endCache(); it++)
+        raw_bytes += it->second.length();
+    REQUIRE(bigj.enableCacheCompression(3, 4096));
+    REQUIRE(bigj.hasCacheCompression());
+    REQUIRE(bigj.atCache("k5") == "");
+    REQUIRE(bigj.packedBytes() < raw_bytes);
+    // entries cached later are also compressed
+    REQUIRE(bigj.size() == 200);
+    REQUIRE(bigj.atCache("k150") == "");
+    REQUIRE(bigj["k150"]["v"] == 150);
+    REQUIRE(bigj.getRaw("k7") == "{\"name\":\"entry number 7\",\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"text\":\"" + std::string(200, 'x') + "\",\"v\":7}");
+    // toCache compresses again
+    REQUIRE(bigj["k5"]["tags"][2] == "gamma");
+    std::size_t before = bigj.packedBytes();
+    bigj.toCache("k5");
+    REQUIRE(bigj.packedBytes() > before);
+    REQUIRE(bigj["k5"]["v"] == 5);
+    std::vector<nlohmann::json*> out = bigj.getKeys({ "k10", "k11" }, 2);
+    REQUIRE((*out[1])["v"] == 11);
+    bigj.loadAll(2);
+    REQUIRE(bigj.packedBytes() == 0);
+    REQUIRE(bigj["k199"]["v"] == 199);
+    REQUIRE(!bigj.hasError);
+}
+#endif
+
+TEST_CASE("bigj spill to disk")
+{
+    std::stringstream ss;
+    ss << "{";
+    for (int i = 0; i < 100; i++)
+        ss << (i ? "," : "") << "\"k" << i << "\":{\"text\":\"" << std::string(100, 'a' + (i % 26)) << "\",\"v\":" << i << "}";
+    ss << "}";
+    VastJSON bigj{new std::istringstream(ss.str())};
+    bigj.getUntil("k9");
+    REQUIRE(bigj.cacheBytes() > 1000);
+    // entries already cached are spilled until under threshold
+    REQUIRE(bigj.setSpillThreshold(1000));
+    REQUIRE(bigj.cacheBytes() <= 1000);
+    REQUIRE(bigj.spilledBytes() > 0);
+    REQUIRE(bigj.atCache("k0") == "");
+    // later entries are spilled while over threshold
+    REQUIRE(bigj.size() == 100);
+    REQUIRE(bigj.cacheBytes() <= 1000);
+    REQUIRE(bigj["k0"]["v"] == 0);
+    REQUIRE(bigj["k50"]["text"] == std::string(100, 'a' + (50 % 26)));
+    REQUIRE(bigj.getRaw("k60") == "{\"text\":\"" + std::string(100, 'a' + (60 % 26)) + "\",\"v\":60}");
+    bigj.unload("k61");
+    REQUIRE(bigj.getRaw("k61") == "");
+    std::vector<nlohmann::json*> out = bigj.getKeys({ "k70", "k71" }, 2);
+    REQUIRE((*out[1])["v"] == 71);
+    bigj.loadAll(2);
+    REQUIRE(bigj.spilledBytes() == 0);
+    REQUIRE(bigj.cacheBytes() == 0);
+    REQUIRE(bigj["k99"]["v"] == 99);
+    REQUIRE(!bigj.hasError);
+    // entries evicted by memory budget are spilled again over freed extents (segment does not grow)
+    std::stringstream ss2;
+    ss2 << "{";
+    for (int i = 0; i < 200; i++)
+        ss2 << (i ? "," : "") << "\"k" << i << "\":{\"text\":\"" << std::string(480, 'a' + (i % 26)) << "\"}";
+    ss2 << "}";
+    VastJSON bigj2{new std::istringstream(ss2.str())};
+    REQUIRE(bigj2.setSpillThreshold(1000));
+    bigj2.setMemoryBudget(5000);
+    REQUIRE(bigj2.size() == 200);
+    std::size_t segment = bigj2.spillFileBytes();
+    REQUIRE(segment > 0);
+    for (int round = 0; round < 5; round++)
+        for (int i = 0; i < 200; i++)
+            REQUIRE(bigj2["k" + std::to_string(i)]["text"].get<std::string>().length() == 480);
+    REQUIRE(bigj2.spillFileBytes() <= segment);
+    REQUIRE(!bigj2.hasError);
+}
+
+TEST_CASE("bigj stats counters")
+{
+    std::string str = "{\"A\":[1,2,3],\"B\":{\"B1\":10,\"B2\":\"abcd\"},\"C\":7,\"Z\":\"string\"}";
+    VastJSON bigj{new std::istringstream(str)};
+    REQUIRE(!bigj.hasStats());
+    REQUIRE(bigj.getStats().parse_calls == 0);
+    bigj.enableStats();
+    REQUIRE(bigj.hasStats());
+    REQUIRE(bigj["B"]["B1"] == 10);
+    StatsVastJSON st = bigj.getStats();
+    REQUIRE(st.entries_indexed == 2);
+    REQUIRE(st.bytes_scanned > 0);
+    REQUIRE(st.parse_calls == 1);
+    REQUIRE(st.parse_bytes == std::string("{\"B1\":10,\"B2\":\"abcd\"}").length());
+    REQUIRE(st.cache_misses == 1);
+    REQUIRE(st.cache_hits == 0);
+    REQUIRE(st.json_bytes > 0);
+    REQUIRE(st.peak_cache_bytes >= st.cache_bytes);
+    REQUIRE(bigj["B"]["B2"] == "abcd");
+    REQUIRE(bigj.getStats().cache_hits == 1);
+    REQUIRE(bigj["C"] == 7);
+    REQUIRE(bigj.size() == 4);
+    st = bigj.getStats();
+    REQUIRE(st.entries_indexed == 4);
+    REQUIRE(st.bytes_scanned == str.length());
+    bigj.toCache("B");
+    st = bigj.getStats();
+    REQUIRE(st.serializations == 1);
+    REQUIRE(st.json_bytes < st.peak_json_bytes);
+    bigj.setMemoryBudget(1);
+    REQUIRE(bigj["A"][0] == 1);
+    REQUIRE(bigj["B"]["B1"] == 10);
+    st = bigj.getStats();
+    REQUIRE(st.evictions == 2);
+    REQUIRE(st.parse_calls == 4);
+    bigj.resetStats();
+    REQUIRE(bigj.getStats().parse_calls == 0);
+    bigj.disableStats();
+    REQUIRE(!bigj.hasStats());
+}
+
+TEST_CASE("bigj memory usage per entry and tier")
+{
+    std::string big(1000, 'x');
+    std::string str = "{\"A\":{\"text\":\"" + big + "\"},\"B\":{\"B1\":10,\"B2\":\"abcd\"},\"Z\":[1,2,3]}";
+    VastJSON bigj{new std::istringstream(str)};
+    REQUIRE(bigj.size() == 3);
+    MemoryVastJSON a = bigj.memoryUsage("A");
+    REQUIRE(a.cache > big.length());
+    REQUIRE(a.json == 0);
+    REQUIRE(a.keys > 0);
+    REQUIRE(a.other == 0);
+    REQUIRE(bigj.memoryUsage("missing").total() == 0);
+    // parsing moves bytes from string cache to parsed json
+    REQUIRE(bigj["A"]["text"] == big);
+    a = bigj.memoryUsage("A");
+    REQUIRE(a.cache == 0);
+    REQUIRE(a.json > big.length());
+    REQUIRE(a.json == jsonFootprint(bigj["A"]));
+    // totals are sums over entries (plus structures owned by no entry)
+    MemoryVastJSON sum;
+    int n = 0;
+    bigj.memoryUsage([&](const std::string&, const MemoryVastJSON& m) {
+        sum.cache += m.cache;
+        sum.json += m.json;
+        sum.keys += m.keys;
+        n++;
+    });
+    REQUIRE(n == 3);
+    MemoryVastJSON all = bigj.memoryUsage();
+    REQUIRE(all.cache == sum.cache);
+    REQUIRE(all.json == sum.json);
+    REQUIRE(all.keys == sum.keys);
+    REQUIRE(all.total() >= sum.cache + sum.json + sum.keys);
+    bigj.unload("A");
+    REQUIRE(bigj.memoryUsage("A").json == 0);
+    REQUIRE(bigj.memoryUsage().json < all.json);
+    // small strings live inside the object
+    std::string small = "ab";
+    REQUIRE(stringHeap(small) == 0);
+    REQUIRE(stringHeap(big) > big.length());
+}